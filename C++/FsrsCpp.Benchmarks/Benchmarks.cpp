@@ -0,0 +1,450 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <span>
+#include <algorithm>
+#include <filesystem>
+
+import FsrsCpp;
+import FsrsCpp.Optimizer;
+import FsrsCpp.Queue;
+import FsrsCpp.Pipeline;
+import FsrsCpp.Replay;
+import FsrsCpp.Service;
+
+using namespace FsrsCpp;
+
+namespace
+{
+    constexpr std::size_t card_count = 1 << 16;
+
+    auto per_card_counters(benchmark::State& state, std::size_t cards_per_iteration) -> void
+    {
+        auto cards = static_cast<double>(state.iterations() * cards_per_iteration);
+        state.counters["cards/s"] = benchmark::Counter(cards, benchmark::Counter::kIsRate);
+        state.counters["time/card"] = benchmark::Counter(cards, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    }
+
+    auto realistic_ratings(std::size_t count, std::uint32_t seed) -> std::vector<Rating>
+    {
+        auto rand_gen = std::mt19937(seed);
+        auto distribution = std::discrete_distribution<int>({ 0.10, 0.15, 0.65, 0.10 });
+        auto ratings = std::vector<Rating>(count);
+        for (auto& rating : ratings)
+            rating = static_cast<Rating>(distribution(rand_gen) + 1);
+        return ratings;
+    }
+
+    auto review_histories(std::size_t count, int reviews_per_card) -> std::vector<ReviewHistory>
+    {
+        auto scheduler = Scheduler(SchedulerConfig::get_default(), 5);
+        auto ratings = realistic_ratings(count * static_cast<std::size_t>(reviews_per_card), 17);
+        auto histories = std::vector<ReviewHistory>(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            auto card = Card::create(static_cast<long long>(i));
+            auto elapsed = days_t(0.0);
+            for (auto r = 0; r < reviews_per_card; ++r) {
+                auto rating = ratings[i * static_cast<std::size_t>(reviews_per_card) + static_cast<std::size_t>(r)];
+                histories[i].push_back({ rating, elapsed });
+                card = scheduler.review_card(card, rating, elapsed, static_cast<std::uint64_t>(r));
+                elapsed = card.interval;
+            }
+        }
+        return histories;
+    }
+
+    auto card_in_state(const Scheduler& scheduler, long long id, State target) -> Card
+    {
+        auto card = Card::create(id);
+        if (target == State::New)
+            return card;
+        card = scheduler.review_card(card, Rating::Good, days_t(0.0), 0);
+        if (target == State::Learning)
+            return card;
+        card = scheduler.review_card(card, Rating::Easy, card.interval, 1);
+        for (auto i = 2ULL; i < 6; ++i)
+            card = scheduler.review_card(card, Rating::Good, card.interval, i);
+        if (target == State::Review)
+            return card;
+        return scheduler.review_card(card, Rating::Again, card.interval, 6);
+    }
+
+    auto mixed_deck(const Scheduler& scheduler, std::size_t count) -> std::vector<Card>
+    {
+        auto rand_gen = std::mt19937(11);
+        auto distribution = std::discrete_distribution<int>({ 0.15, 0.10, 0.70, 0.05 });
+        auto cards = std::vector<Card>(count);
+        for (std::size_t i = 0; i < count; ++i)
+            cards[i] = card_in_state(scheduler, static_cast<long long>(i), static_cast<State>(distribution(rand_gen)));
+        return cards;
+    }
+
+    struct ColumnStore
+    {
+        std::vector<long long> card_id;
+        std::vector<days_t> interval;
+        std::vector<double> stability;
+        std::vector<double> difficulty;
+        std::vector<State> state;
+        std::vector<int> step;
+
+        explicit ColumnStore(const std::vector<Card>& cards)
+        {
+            for (const auto& card : cards) {
+                card_id.push_back(card.card_id);
+                interval.push_back(card.interval);
+                stability.push_back(card.stability);
+                difficulty.push_back(card.difficulty);
+                state.push_back(card.state);
+                step.push_back(card.step);
+            }
+        }
+
+        auto columns() -> CardColumns { return { card_id, interval, stability, difficulty, state, step }; }
+    };
+}
+
+static void BM_ReviewCard(benchmark::State& state)
+{
+    auto scheduler = Scheduler(SchedulerConfig::get_default(), 1);
+    auto card = card_in_state(scheduler, 1, static_cast<State>(state.range(0)));
+    auto rating = static_cast<Rating>(state.range(1));
+    auto review_index = std::uint64_t{};
+    for (auto _ : state) {
+        auto next = scheduler.review_card(card, rating, card.interval, review_index++);
+        benchmark::DoNotOptimize(next);
+    }
+    per_card_counters(state, 1);
+}
+BENCHMARK(BM_ReviewCard)->ArgNames({ "state", "rating" })->ArgsProduct({ { 0, 1, 2, 3 }, { 1, 2, 3, 4 } });
+
+static void BM_ReviewCardMixed(benchmark::State& state)
+{
+    auto scheduler = Scheduler(SchedulerConfig::get_default(), 1);
+    auto cards = mixed_deck(scheduler, card_count);
+    auto ratings = realistic_ratings(card_count, 3);
+    auto review_index = std::uint64_t{};
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < cards.size(); ++i) {
+            auto next = scheduler.review_card(cards[i], ratings[i], cards[i].interval, review_index);
+            benchmark::DoNotOptimize(next);
+        }
+        ++review_index;
+    }
+    per_card_counters(state, cards.size());
+}
+BENCHMARK(BM_ReviewCardMixed);
+
+static void BM_ReviewCardMixedMt19937(benchmark::State& state)
+{
+    auto rand_gen = std::mt19937(1);
+    auto scheduler = Scheduler(SchedulerConfig::get_default(), rand_gen);
+    auto cards = mixed_deck(scheduler, card_count);
+    auto ratings = realistic_ratings(card_count, 3);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < cards.size(); ++i) {
+            auto next = scheduler.review_card(cards[i], ratings[i], cards[i].interval);
+            benchmark::DoNotOptimize(next);
+        }
+    }
+    per_card_counters(state, cards.size());
+}
+BENCHMARK(BM_ReviewCardMixedMt19937);
+
+static void BM_ReviewCardMixedSplitMix(benchmark::State& state)
+{
+    auto rand_gen = SplitMix64(1);
+    auto scheduler = Scheduler(SchedulerConfig::get_default(), 1);
+    auto cards = mixed_deck(scheduler, card_count);
+    auto ratings = realistic_ratings(card_count, 3);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < cards.size(); ++i) {
+            auto next = scheduler.review_card(cards[i], ratings[i], cards[i].interval, rand_gen);
+            benchmark::DoNotOptimize(next);
+        }
+    }
+    per_card_counters(state, cards.size());
+}
+BENCHMARK(BM_ReviewCardMixedSplitMix);
+
+static void BM_StaticSchedulerReviewCardMixed(benchmark::State& state)
+{
+    auto scheduler = Scheduler(SchedulerConfig::get_default(), 1);
+    auto static_scheduler = StaticScheduler<DefaultSchedulerParams>(1);
+    auto cards = mixed_deck(scheduler, card_count);
+    auto ratings = realistic_ratings(card_count, 3);
+    auto review_index = std::uint64_t{};
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < cards.size(); ++i) {
+            auto next = static_scheduler.review_card(cards[i], ratings[i], cards[i].interval, review_index);
+            benchmark::DoNotOptimize(next);
+        }
+        ++review_index;
+    }
+    per_card_counters(state, cards.size());
+}
+BENCHMARK(BM_StaticSchedulerReviewCardMixed);
+
+static void BM_CalculateNextReviewInterval(benchmark::State& state)
+{
+    auto scheduler = Scheduler(SchedulerConfig::get_default());
+    auto stability = 0.5;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(scheduler.calculate_next_review_interval(stability));
+        stability = (stability > 3000.0) ? 0.5 : stability * 1.01;
+    }
+    per_card_counters(state, 1);
+}
+BENCHMARK(BM_CalculateNextReviewInterval);
+
+static void BM_FuzzInterval(benchmark::State& state)
+{
+    auto interval = 3.0;
+    auto review_index = std::uint64_t{};
+    for (auto _ : state) {
+        auto fuzzed = FsrsAlgorithm::fuzz_interval(days_t(interval), 36500, [&](int min_days, int max_days) {
+            return FsrsAlgorithm::counter_draw(1, 42, review_index, min_days, max_days);
+        });
+        benchmark::DoNotOptimize(fuzzed);
+        ++review_index;
+        interval = (interval > 3000.0) ? 3.0 : interval + 1.0;
+    }
+    per_card_counters(state, 1);
+}
+BENCHMARK(BM_FuzzInterval);
+
+static void BM_ReviewCards(benchmark::State& state)
+{
+    auto scheduler = Scheduler(SchedulerConfig::get_default(), 1);
+    auto mode = static_cast<BatchMode>(state.range(0));
+    auto deck = mixed_deck(scheduler, card_count);
+    auto ratings = realistic_ratings(card_count, 3);
+    auto intervals = std::vector<days_t>(card_count);
+    for (std::size_t i = 0; i < card_count; ++i)
+        intervals[i] = deck[i].interval;
+    auto review_indices = std::vector<std::uint64_t>(card_count);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto store = ColumnStore(deck);
+        state.ResumeTiming();
+
+        scheduler.review_cards(store.columns(), ratings, intervals, review_indices, mode);
+        benchmark::ClobberMemory();
+    }
+    per_card_counters(state, card_count);
+}
+BENCHMARK(BM_ReviewCards)->ArgName("vectorized")->Arg(0)->Arg(1);
+
+static void BM_ImportDeck(benchmark::State& state)
+{
+    auto scheduler = Scheduler(SchedulerConfig::get_default(), 1);
+    auto bulk = state.range(0) != 0;
+    auto count = std::size_t{ 100000 };
+    auto ratings = realistic_ratings(count, 9);
+    auto store = ColumnStore(std::vector<Card>(count));
+    for (auto _ : state) {
+        if (bulk) {
+            scheduler.import_cards(store.columns(), 0, ratings);
+        }
+        else {
+            for (std::size_t i = 0; i < count; ++i) {
+                auto card = scheduler.review_card(Card::create(static_cast<long long>(i)), ratings[i], days_t(0.0), 0);
+                store.stability[i] = card.stability;
+                store.difficulty[i] = card.difficulty;
+                store.interval[i] = card.interval;
+                store.state[i] = card.state;
+                store.step[i] = card.step;
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    per_card_counters(state, count);
+}
+BENCHMARK(BM_ImportDeck)->ArgName("bulk")->Arg(0)->Arg(1);
+
+static void BM_EvaluateConfigs(benchmark::State& state)
+{
+    auto lockstep = state.range(0) != 0;
+    auto histories = review_histories(card_count / 4, 10);
+    auto configs = std::vector<SchedulerConfig>(8, SchedulerConfig::get_default());
+    for (std::size_t k = 0; k < configs.size(); ++k)
+        for (auto& p : configs[k].parameters)
+            p *= 0.9 + 0.025 * static_cast<double>(k);
+    auto evaluator = Evaluator(configs);
+    auto optimizer = Optimizer(OptimizerConfig::get_default());
+    for (auto _ : state) {
+        if (lockstep) {
+            benchmark::DoNotOptimize(evaluator.evaluate(histories));
+        }
+        else {
+            for (const auto& config : configs)
+                benchmark::DoNotOptimize(optimizer.log_loss(config.parameters, histories));
+        }
+    }
+    per_card_counters(state, histories.size() * configs.size());
+}
+BENCHMARK(BM_EvaluateConfigs)->ArgName("lockstep")->Arg(0)->Arg(1)->UseRealTime();
+
+static void BM_RescheduleAll(benchmark::State& state)
+{
+    auto scheduler = Scheduler(SchedulerConfig::get_default());
+    auto count = static_cast<std::size_t>(state.range(0));
+    auto stability = std::vector<double>(count);
+    for (std::size_t i = 0; i < count; ++i)
+        stability[i] = 0.1 + static_cast<double>(i % 5000) * 0.7;
+    auto intervals = std::vector<days_t>(count);
+    for (auto _ : state) {
+        scheduler.reschedule_all(stability, intervals);
+        benchmark::ClobberMemory();
+    }
+    per_card_counters(state, count);
+}
+BENCHMARK(BM_RescheduleAll)->Arg(card_count)->Arg(card_count * 16)->UseRealTime();
+
+static void BM_IntervalTableLookup(benchmark::State& state)
+{
+    auto table = Scheduler(SchedulerConfig::get_default()).interval_table();
+    auto stability = std::vector<double>(card_count);
+    for (std::size_t i = 0; i < card_count; ++i)
+        stability[i] = 0.1 + static_cast<double>(i % 5000) * 0.7;
+    auto intervals = std::vector<days_t>(card_count);
+    for (auto _ : state) {
+        table.lookup(stability, intervals);
+        benchmark::ClobberMemory();
+    }
+    per_card_counters(state, card_count);
+}
+BENCHMARK(BM_IntervalTableLookup);
+
+static void BM_GetRetrievabilityBatch(benchmark::State& state)
+{
+    auto scheduler = Scheduler(SchedulerConfig::get_default());
+    auto stability = std::vector<double>(card_count);
+    auto elapsed = std::vector<days_t>(card_count);
+    for (std::size_t i = 0; i < card_count; ++i) {
+        stability[i] = 0.1 + static_cast<double>(i % 5000) * 0.7;
+        elapsed[i] = days_t(static_cast<double>(i % 365));
+    }
+    auto retrievability = std::vector<double>(card_count);
+    auto mode = static_cast<BatchMode>(state.range(0));
+    for (auto _ : state) {
+        scheduler.get_retrievability(stability, elapsed, retrievability, mode);
+        benchmark::ClobberMemory();
+    }
+    per_card_counters(state, card_count);
+}
+BENCHMARK(BM_GetRetrievabilityBatch)->ArgName("vectorized")->Arg(0)->Arg(1);
+
+static void BM_SimdBackend(benchmark::State& state)
+{
+    const auto& backend = FsrsSimd::supported_backends()[static_cast<std::size_t>(state.range(0))];
+    auto coefficients = FsrsAlgorithm::precompute_coefficients(FsrsAlgorithm::check_and_fill_parameters(SchedulerConfig::get_default().parameters), 0.9);
+    auto stability = std::vector<double>(card_count);
+    auto difficulty = std::vector<double>(card_count, 5.0);
+    auto rating = std::vector<double>(card_count);
+    auto is_new = std::vector<double>(card_count, 0.0);
+    auto elapsed = std::vector<double>(card_count);
+    for (std::size_t i = 0; i < card_count; ++i) {
+        stability[i] = 0.1 + static_cast<double>(i % 5000) * 0.7;
+        rating[i] = static_cast<double>(1 + i % 4);
+        elapsed[i] = static_cast<double>(i % 365);
+    }
+    auto next_stability = stability;
+    auto intervals = std::vector<double>(card_count);
+    for (auto _ : state) {
+        std::ranges::copy(stability, next_stability.begin());
+        backend.memory_states(coefficients, { next_stability.data(), difficulty.data(), rating.data(), is_new.data(), elapsed.data() }, card_count);
+        backend.intervals(coefficients.interval_multiplier, 36500.0, next_stability.data(), intervals.data(), card_count);
+        benchmark::ClobberMemory();
+    }
+    state.SetLabel(backend.name);
+    per_card_counters(state, card_count);
+}
+BENCHMARK(BM_SimdBackend)->ArgName("backend")->DenseRange(0, static_cast<int>(FsrsSimd::supported_backends().size()) - 1);
+
+static void BM_SchedulerConstruction(benchmark::State& state)
+{
+    const auto& config = SchedulerConfig::get_default();
+    for (auto _ : state) {
+        auto scheduler = Scheduler(config);
+        benchmark::DoNotOptimize(scheduler);
+    }
+}
+BENCHMARK(BM_SchedulerConstruction);
+
+static void BM_SchedulerConstructionFixed(benchmark::State& state)
+{
+    auto config = FixedSchedulerConfig::from(SchedulerConfig::get_default());
+    for (auto _ : state) {
+        auto scheduler = Scheduler(config);
+        benchmark::DoNotOptimize(scheduler);
+    }
+}
+BENCHMARK(BM_SchedulerConstructionFixed);
+
+static void BM_DueQueueServe(benchmark::State& state)
+{
+    auto scheduler = Scheduler(SchedulerConfig::get_default(), 1);
+    auto deck = mixed_deck(scheduler, card_count);
+    for (auto _ : state) {
+        auto queue = DueQueue();
+        for (const auto& card : deck)
+            queue.push(card, days_t(0.0));
+        auto served = std::size_t{};
+        for (auto day = 0; !queue.empty(); ++day) {
+            while (auto card_id = queue.pop_due(days_t(day))) {
+                benchmark::DoNotOptimize(card_id);
+                ++served;
+            }
+        }
+        benchmark::DoNotOptimize(served);
+    }
+    per_card_counters(state, card_count);
+}
+BENCHMARK(BM_DueQueueServe);
+
+static void BM_ReviewPipeline(benchmark::State& state)
+{
+    auto scheduler = Scheduler(SchedulerConfig::get_default(), 1);
+    auto deck = mixed_deck(scheduler, card_count);
+    auto ratings = realistic_ratings(card_count, 3);
+    auto pipeline = ReviewPipeline(scheduler, [](std::span<const Card> cards) { benchmark::DoNotOptimize(cards.data()); });
+    auto futures = std::vector<std::future<Card>>(card_count);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < card_count; ++i)
+            futures[i] = pipeline.submit({ deck[i], ratings[i], deck[i].interval, 0 });
+        for (auto& future : futures)
+            benchmark::DoNotOptimize(future.get());
+    }
+    per_card_counters(state, card_count);
+}
+BENCHMARK(BM_ReviewPipeline)->UseRealTime();
+
+static void BM_ShardedService(benchmark::State& state)
+{
+    auto config = ServiceConfig::get_default();
+    config.directory = std::filesystem::temp_directory_path() / "fsrs_service_benchmark";
+    config.shard_count = static_cast<std::size_t>(state.range(0));
+    config.sync_log = false;
+    std::filesystem::remove_all(config.directory);
+    auto ratings = realistic_ratings(card_count, 13);
+    auto events = std::vector<ReviewEvent>(card_count);
+    auto now = timestamp_t(std::chrono::milliseconds(1700000000000LL));
+    {
+        auto service = ShardedService(Scheduler(SchedulerConfig::get_default(), 1), config);
+        for (auto _ : state) {
+            now += std::chrono::hours(24);
+            for (std::size_t i = 0; i < card_count; ++i)
+                events[i] = { static_cast<long long>(i), now, ratings[i] };
+            service.submit(events).get();
+        }
+    }
+    std::filesystem::remove_all(config.directory);
+    per_card_counters(state, card_count);
+}
+BENCHMARK(BM_ShardedService)->ArgName("shards")->Arg(1)->Arg(4)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -6,14 +6,78 @@
 #include <span>
 #include <string>
 #include <format>
+#include <thread>
+#include <bit>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <atomic>
+#include <coroutine>
+#include <future>
+#include <mutex>
+#include <memory_resource>
+#include <algorithm>
+#include <tuple>
 
 import FsrsCpp;
+import FsrsCpp.Optimizer;
+import FsrsCpp.Replay;
+import FsrsCpp.Store;
+import FsrsCpp.Simulator;
+import FsrsCpp.Cache;
+import FsrsCpp.Index;
+import FsrsCpp.Queue;
+import FsrsCpp.Pipeline;
+import FsrsCpp.Service;
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 using namespace FsrsCpp;
 
+namespace
+{
+    thread_local bool count_allocations = false;
+    thread_local std::size_t allocation_count = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    if (count_allocations)
+        ++allocation_count;
+    if (auto p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return ::operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
 namespace FsrsTests
 {
+    struct DetachedTask {
+        struct promise_type {
+            auto get_return_object() -> DetachedTask { return {}; }
+            auto initial_suspend() noexcept -> std::suspend_never { return {}; }
+            auto final_suspend() noexcept -> std::suspend_never { return {}; }
+            auto return_void() -> void {}
+            auto unhandled_exception() -> void { std::terminate(); }
+        };
+    };
+
+    struct NoStepsParams : DefaultSchedulerParams {
+        static constexpr std::array<days_t, 0> learning_steps = {};
+        static constexpr std::array<days_t, 0> relearning_steps = {};
+        static constexpr bool enable_fuzzing = false;
+    };
+
+    // Fixed so that a failing randomized test fails the same way on every run.
+    constexpr std::mt19937::result_type test_seed = 20240611;
+
     TEST_CLASS(BasicTests)
     {
     private:
@@ -31,6 +95,27 @@ namespace FsrsTests
             }
         }
 
+        auto simulate_histories(std::size_t card_count, int reviews_per_card) -> std::vector<ReviewHistory>
+        {
+            auto scheduler = Scheduler(SchedulerConfig::get_default(), 7);
+            auto uniform = std::uniform_real_distribution<double>(0.0, 1.0);
+            auto ratings = std::uniform_int_distribution<int>(2, 4);
+            auto histories = std::vector<ReviewHistory>(card_count);
+            for (size_t id = 0; id < card_count; ++id) {
+                auto card = Card::create(static_cast<long long>(id));
+                auto rating = static_cast<Rating>(ratings(rand_gen) - 1);
+                auto elapsed = days_t(0.0);
+                for (auto i = 0; i < reviews_per_card; ++i) {
+                    histories[id].push_back({ rating, elapsed });
+                    card = scheduler.review_card(card, rating, elapsed, static_cast<std::uint64_t>(i));
+                    elapsed = card.interval;
+                    auto recalled = uniform(rand_gen) < scheduler.get_retrievability(card, elapsed);
+                    rating = recalled ? static_cast<Rating>(ratings(rand_gen)) : Rating::Again;
+                }
+            }
+            return histories;
+        }
+
         auto run_reviews(Scheduler& scheduler, const std::vector<std::pair<Rating, int>>& reviews) -> Card
         {
             auto card = Card::create(1L);
@@ -47,7 +132,7 @@ namespace FsrsTests
         }
 
     public:
-        BasicTests() : rand_gen(std::random_device{}()) {}
+        BasicTests() : rand_gen(test_seed) {}
 
         TEST_METHOD(TestNextInterval)
         {
@@ -200,6 +285,1218 @@ namespace FsrsTests
             Assert::IsTrue(card.interval.count() <= config.maximum_interval);
         }
 
+        TEST_METHOD(TestReviewCardsMatchesReviewCard)
+        {
+            constexpr auto card_count = 1000;
+            auto scalar_gen = std::mt19937(42);
+            auto batch_gen = std::mt19937(42);
+            auto scalar_scheduler = Scheduler(SchedulerConfig::get_default(), scalar_gen);
+            auto batch_scheduler = Scheduler(SchedulerConfig::get_default(), batch_gen);
+
+            auto cards = std::vector<Card>();
+            for (auto i = 0; i < card_count; i++)
+                cards.push_back(Card::create(i));
+
+            auto ids = std::vector<long long>(card_count);
+            auto intervals = std::vector<days_t>(card_count);
+            auto stabilities = std::vector<double>(card_count);
+            auto difficulties = std::vector<double>(card_count);
+            auto states = std::vector<State>(card_count);
+            auto steps = std::vector<int>(card_count);
+            std::iota(ids.begin(), ids.end(), 0LL);
+            auto columns = CardColumns{ ids, intervals, stabilities, difficulties, states, steps };
+
+            auto rating_gen = std::mt19937(7);
+            auto rating_dis = std::uniform_int_distribution<>(1, 4);
+            auto ratings = std::vector<Rating>(card_count);
+            auto review_intervals = std::vector<days_t>(card_count);
+
+            for (auto round = 0; round < 20; round++)
+            {
+                for (auto i = 0; i < card_count; i++) {
+                    ratings[i] = static_cast<Rating>(rating_dis(rating_gen));
+                    review_intervals[i] = cards[i].interval;
+                    cards[i] = scalar_scheduler.review_card(cards[i], ratings[i], review_intervals[i]);
+                }
+                batch_scheduler.review_cards(columns, ratings, review_intervals);
+
+                for (auto i = 0; i < card_count; i++) {
+                    Assert::IsTrue(cards[i].interval == intervals[i], L"Interval mismatch.");
+                    Assert::IsTrue(cards[i].stability == stabilities[i], L"Stability mismatch.");
+                    Assert::IsTrue(cards[i].difficulty == difficulties[i], L"Difficulty mismatch.");
+                    Assert::IsTrue(cards[i].state == states[i], L"State mismatch.");
+                    Assert::AreEqual(cards[i].step, steps[i], L"Step mismatch.");
+                }
+            }
+        }
+
+        TEST_METHOD(TestFastMathUlpBounds)
+        {
+            auto ulp_distance = [](double a, double b) { return std::abs(std::bit_cast<long long>(a) - std::bit_cast<long long>(b)); };
+            auto gen = std::mt19937_64(3);
+            auto exp_dis = std::uniform_real_distribution<>(-708.0, 709.0);
+            auto log_dis = std::uniform_real_distribution<>(-700.0, 700.0);
+            auto base_dis = std::uniform_real_distribution<>(-7.0, 14.0);
+            auto exponent_dis = std::uniform_real_distribution<>(-2.0, 2.0);
+
+            for (auto i = 0; i < 100000; i++)
+            {
+                auto x = exp_dis(gen);
+                Assert::IsTrue(ulp_distance(FsrsSimd::fast_exp(x), std::exp(x)) <= 1, L"fast_exp exceeds 1 ulp.");
+
+                auto y = std::exp(log_dis(gen));
+                Assert::IsTrue(ulp_distance(FsrsSimd::fast_log(y), std::log(y)) <= 1, L"fast_log exceeds 1 ulp.");
+
+                auto base = std::exp(base_dis(gen));
+                auto exponent = exponent_dis(gen);
+                auto bound = 3.0 + std::abs(exponent * std::log(base));
+                Assert::IsTrue(ulp_distance(FsrsSimd::fast_pow(base, exponent), std::pow(base, exponent)) <= bound, L"fast_pow exceeds its bound.");
+            }
+        }
+
+        TEST_METHOD(TestVectorizedReviewCardsMatchesExact)
+        {
+            constexpr auto card_count = 1003;
+            auto config = FsrsCpp::SchedulerConfig(SchedulerConfig::get_default());
+            config.enable_fuzzing = false;
+            auto scheduler = Scheduler(config, rand_gen);
+
+            struct Columns {
+                std::vector<long long> ids = std::vector<long long>(card_count);
+                std::vector<days_t> intervals = std::vector<days_t>(card_count);
+                std::vector<double> stabilities = std::vector<double>(card_count);
+                std::vector<double> difficulties = std::vector<double>(card_count);
+                std::vector<State> states = std::vector<State>(card_count);
+                std::vector<int> steps = std::vector<int>(card_count);
+                auto view() -> CardColumns { return { ids, intervals, stabilities, difficulties, states, steps }; }
+            };
+            auto exact = Columns();
+            auto vectorized = Columns();
+
+            auto rating_gen = std::mt19937(11);
+            auto rating_dis = std::uniform_int_distribution<>(1, 4);
+            auto delay_dis = std::uniform_real_distribution<>(0.0, 3.0);
+            auto ratings = std::vector<Rating>(card_count);
+            auto review_intervals = std::vector<days_t>(card_count);
+
+            for (auto round = 0; round < 20; round++)
+            {
+                for (auto i = 0; i < card_count; i++) {
+                    ratings[i] = static_cast<Rating>(rating_dis(rating_gen));
+                    review_intervals[i] = exact.intervals[i] * delay_dis(rating_gen);
+                }
+                scheduler.review_cards(exact.view(), ratings, review_intervals);
+                scheduler.review_cards(vectorized.view(), ratings, review_intervals, BatchMode::Vectorized);
+
+                for (auto i = 0; i < card_count; i++) {
+                    Assert::AreEqual(exact.stabilities[i], vectorized.stabilities[i], exact.stabilities[i] * 1e-9, L"Stability drifted.");
+                    Assert::AreEqual(exact.difficulties[i], vectorized.difficulties[i], exact.difficulties[i] * 1e-9, L"Difficulty drifted.");
+                    Assert::IsTrue(exact.states[i] == vectorized.states[i], L"State mismatch.");
+                    Assert::AreEqual(exact.steps[i], vectorized.steps[i], L"Step mismatch.");
+                    Assert::AreEqual(exact.intervals[i].count(), vectorized.intervals[i].count(), 1.0, L"Interval drifted.");
+                }
+            }
+        }
+
+        TEST_METHOD(TestSharedSchedulerAcrossThreads)
+        {
+            constexpr auto card_count = 4000;
+            constexpr auto review_count = 12;
+            const auto scheduler = Scheduler([] { return FsrsCpp::SchedulerConfig(SchedulerConfig::get_default()); }(), 42);
+
+            auto replay = [&](long long first, long long last, std::vector<Card>& out) {
+                for (auto id = first; id < last; id++) {
+                    auto card = Card::create(id);
+                    for (auto i = 0; i < review_count; i++) {
+                        auto rating = static_cast<Rating>(1 + (id + i) % 4);
+                        card = scheduler.review_card(card, rating, card.interval, i);
+                    }
+                    out[id] = card;
+                }
+            };
+
+            auto serial = std::vector<Card>(card_count);
+            replay(0, card_count, serial);
+
+            auto parallel = std::vector<Card>(card_count);
+            auto threads = std::vector<std::thread>();
+            for (auto t = 0; t < 4; t++)
+                threads.emplace_back(replay, t * card_count / 4, (t + 1) * card_count / 4, std::ref(parallel));
+            for (auto& thread : threads)
+                thread.join();
+
+            for (auto i = 0; i < card_count; i++) {
+                Assert::IsTrue(serial[i].interval == parallel[i].interval, L"Interval mismatch.");
+                Assert::IsTrue(serial[i].stability == parallel[i].stability, L"Stability mismatch.");
+            }
+
+            auto card = Card{ .card_id = 1L, .interval = days_t(30), .stability = 30.0, .difficulty = 5.0, .state = State::Review, .step = 0 };
+            Assert::IsTrue(scheduler.review_card(card, Rating::Good, card.interval, 3).interval == scheduler.review_card(card, Rating::Good, card.interval, 3).interval);
+
+            auto unseeded = Scheduler(SchedulerConfig::get_default());
+            Assert::ExpectException<std::logic_error>([&] { unseeded.review_card(card, Rating::Good, card.interval); });
+        }
+
+        TEST_METHOD(TestRescheduleAllMatchesNextInterval)
+        {
+            auto scheduler = Scheduler(SchedulerConfig::get_default());
+            auto stabilities = std::vector<double>(100000);
+            for (size_t i = 0; i < stabilities.size(); ++i)
+                stabilities[i] = 0.001 + i * 0.37;
+            auto intervals = std::vector<days_t>(stabilities.size());
+
+            scheduler.reschedule_all(stabilities, intervals);
+
+            for (size_t i = 0; i < stabilities.size(); ++i)
+                Assert::IsTrue(scheduler.calculate_next_review_interval(stabilities[i]) == intervals[i], L"Interval mismatch.");
+        }
+
+        TEST_METHOD(TestSimdBackendsAgree)
+        {
+            auto backends = FsrsSimd::supported_backends();
+            Assert::AreEqual(std::string("scalar"), std::string(backends.front().name));
+            Assert::AreEqual(std::string(backends.back().name), std::string(FsrsSimd::backend_name()));
+            Logger::WriteMessage(std::format("selected SIMD backend: {}\n", FsrsSimd::backend_name()).c_str());
+
+            constexpr auto count = std::size_t{ 1003 };
+            auto coefficients = FsrsAlgorithm::precompute_coefficients(FsrsAlgorithm::check_and_fill_parameters(SchedulerConfig::get_default().parameters), 0.9);
+            auto input_gen = std::mt19937(5);
+            auto stability = std::vector<double>(count);
+            auto difficulty = std::vector<double>(count);
+            auto rating = std::vector<double>(count);
+            auto is_new = std::vector<double>(count);
+            auto elapsed = std::vector<double>(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                stability[i] = std::uniform_real_distribution<>(0.01, 1000.0)(input_gen);
+                difficulty[i] = std::uniform_real_distribution<>(1.0, 10.0)(input_gen);
+                rating[i] = std::uniform_int_distribution<>(1, 4)(input_gen);
+                is_new[i] = (i % 7 == 0) ? 1.0 : 0.0;
+                elapsed[i] = std::uniform_real_distribution<>(0.0, 100.0)(input_gen) * (i % 3);
+            }
+            stability[0] = 0.0;
+            const auto halfway = std::vector<double>{ 0.25, 0.5, 1.5, 2.4999999999999996, 2.5, 3.5, 36499.5, 1e7 };
+
+            auto run = [&](const FsrsSimd::Backend& backend) {
+                auto states = std::vector<double>(stability);
+                auto difficulties = std::vector<double>(difficulty);
+                backend.memory_states(coefficients, { states.data(), difficulties.data(), rating.data(), is_new.data(), elapsed.data() }, count);
+                auto retrievability = std::vector<double>(count);
+                backend.retrievability(coefficients.factor, coefficients.decay, stability.data(), elapsed.data(), retrievability.data(), count);
+                auto intervals = std::vector<double>(halfway.size());
+                backend.intervals(1.0, 36500.0, halfway.data(), intervals.data(), halfway.size());
+                return std::tuple{ states, difficulties, retrievability, intervals };
+            };
+
+            auto [scalar_stability, scalar_difficulty, scalar_retrievability, scalar_intervals] = run(backends.front());
+            for (std::size_t i = 0; i < halfway.size(); ++i) {
+                Assert::AreEqual(std::clamp(std::round(halfway[i]), 1.0, 36500.0), scalar_intervals[i], L"Interval kernel does not round like std::round.");
+            }
+            Assert::AreEqual(0.0, scalar_retrievability[0]);
+
+            for (const auto& backend : backends) {
+                auto [vector_stability, vector_difficulty, vector_retrievability, vector_intervals] = run(backend);
+                AssertVectorsAreEqual(scalar_intervals, vector_intervals);
+                for (std::size_t i = 0; i < count; ++i) {
+                    Assert::AreEqual(scalar_stability[i], vector_stability[i], scalar_stability[i] * 1e-12, L"Stability differs between backends.");
+                    Assert::AreEqual(scalar_difficulty[i], vector_difficulty[i], scalar_difficulty[i] * 1e-12, L"Difficulty differs between backends.");
+                    Assert::AreEqual(scalar_retrievability[i], vector_retrievability[i], 1e-12, L"Retrievability differs between backends.");
+                }
+            }
+
+            auto scheduler = Scheduler(SchedulerConfig::get_default());
+            auto elapsed_days = std::vector<days_t>(count);
+            std::ranges::transform(elapsed, elapsed_days.begin(), [](double days) { return days_t(days); });
+            auto exact = std::vector<double>(count);
+            auto vectorized = std::vector<double>(count);
+            scheduler.get_retrievability(stability, elapsed_days, exact);
+            scheduler.get_retrievability(stability, elapsed_days, vectorized, BatchMode::Vectorized);
+            for (std::size_t i = 0; i < count; ++i) {
+                Assert::AreEqual(exact[i], vectorized[i], 1e-12, L"Vectorized retrievability drifted.");
+            }
+        }
+
+        TEST_METHOD(TestStaticSchedulerMatchesScheduler)
+        {
+            auto scheduler = Scheduler(SchedulerConfig::get_default(), 42);
+            auto static_scheduler = StaticScheduler<DefaultSchedulerParams>(42);
+            auto ratings = std::uniform_int_distribution<int>(1, 4);
+
+            for (auto id = 1LL; id <= 100; ++id) {
+                auto expected = Card::create(id);
+                auto actual = expected;
+                for (auto i = 0ULL; i < 20; ++i) {
+                    auto rating = static_cast<Rating>(ratings(rand_gen));
+                    expected = scheduler.review_card(expected, rating, expected.interval, i);
+                    actual = static_scheduler.review_card(actual, rating, actual.interval, i);
+                    Assert::IsTrue(expected.interval == actual.interval && expected.stability == actual.stability
+                        && expected.difficulty == actual.difficulty && expected.state == actual.state && expected.step == actual.step, L"Card mismatch.");
+                }
+            }
+
+            auto scheduler_no_steps = StaticScheduler<NoStepsParams>();
+            auto card = Card::create(1L);
+            auto actual_intervals = std::vector<int>();
+            for (auto rating : { Rating::Again, Rating::Good, Rating::Good, Rating::Good, Rating::Good, Rating::Good }) {
+                card = scheduler_no_steps.review_card(card, rating, card.interval, 0);
+                actual_intervals.push_back(static_cast<int>(card.interval.count()));
+            }
+            AssertVectorsAreEqual({ 1, 2, 6, 17, 44, 102 }, actual_intervals);
+        }
+
+        TEST_METHOD(TestPackedCardRoundTrip)
+        {
+            auto config = FsrsCpp::SchedulerConfig(SchedulerConfig::get_default());
+            config.learning_steps.clear();
+            config.relearning_steps.clear();
+            config.enable_fuzzing = false;
+
+            auto scheduler = Scheduler(config, rand_gen);
+            auto packed = PackedCard::from_card(Card::create(1L));
+            const auto ratings = { Rating::Again, Rating::Good, Rating::Good, Rating::Good, Rating::Good, Rating::Good };
+            const auto expected_intervals = std::vector<int>{ 1, 2, 6, 17, 44, 102 };
+            auto i = 0;
+
+            for (auto rating : ratings) {
+                auto card = packed.to_card();
+                card = scheduler.review_card(card, rating, card.interval);
+                packed = PackedCard::from_card(card);
+                auto unpacked = packed.to_card();
+                Assert::IsTrue(std::abs(unpacked.stability - card.stability) <= 1e-6 * card.stability, L"Stability outside tolerance.");
+                Assert::IsTrue(std::abs(unpacked.difficulty - card.difficulty) <= 1e-4, L"Difficulty outside tolerance.");
+                Assert::IsTrue(std::abs(unpacked.interval.count() - expected_intervals[i++]) <= 1.0, L"Interval outside tolerance.");
+            }
+
+            auto learning = Card{ .card_id = -1700000000000LL, .interval = minutes_t(5.5), .stability = 2.5, .difficulty = 5.0, .state = State::Relearning, .step = 3 };
+            auto unpacked = PackedCard::from_card(learning).to_card();
+            Assert::AreEqual(learning.card_id, unpacked.card_id);
+            Assert::IsTrue(learning.interval == unpacked.interval && learning.state == unpacked.state && learning.step == unpacked.step);
+
+            learning.step = 256;
+            Assert::ExpectException<std::invalid_argument>([&]() { PackedCard::from_card(learning); });
+        }
+
+        TEST_METHOD(TestRetrievability)
+        {
+            auto scheduler = Scheduler(SchedulerConfig::get_default(), rand_gen);
+            auto card = Card::create(1L);
+            Assert::AreEqual(0.0, scheduler.get_retrievability(card, days_t(5.0)));
+
+            card = scheduler.review_card(card, Rating::Good, days_t(0.0));
+            Assert::AreEqual(1.0, scheduler.get_retrievability(card, days_t(0.0)));
+
+            auto decay = -SchedulerConfig::get_default().parameters[20];
+            auto factor = std::pow(0.9, 1.0 / decay) - 1.0;
+            auto expected = std::pow(1.0 + factor * 3.0 / card.stability, decay);
+            Assert::AreEqual(expected, scheduler.get_retrievability(card, days_t(3.0)), 1e-12);
+            Assert::AreEqual(0.9, scheduler.get_retrievability(card, days_t(card.stability)), 1e-12);
+
+            auto stabilities = std::vector<double>{ 0.0, card.stability, 10.0, 100.0 };
+            auto elapsed = std::vector<days_t>{ days_t(1.0), days_t(3.0), days_t(10.0), days_t(400.0) };
+            auto retrievability = std::vector<double>(stabilities.size());
+            scheduler.get_retrievability(stabilities, elapsed, retrievability);
+
+            Assert::AreEqual(0.0, retrievability[0]);
+            for (size_t i = 1; i < stabilities.size(); ++i) {
+                auto reviewed = card;
+                reviewed.stability = stabilities[i];
+                Assert::AreEqual(scheduler.get_retrievability(reviewed, elapsed[i]), retrievability[i]);
+            }
+        }
+
+        TEST_METHOD(TestOptimizerGradientMatchesFiniteDifferences)
+        {
+            auto histories = simulate_histories(200, 8);
+            auto optimizer = Optimizer(OptimizerConfig::get_default());
+            auto parameters = SchedulerConfig::get_default().parameters;
+            parameters[7] = 0.05;
+            parameters[20] = 0.3;
+
+            auto gradient = optimizer.loss_gradient(parameters, histories);
+            for (size_t i = 0; i < parameters.size(); ++i) {
+                constexpr double h = 1e-6;
+                auto plus = parameters;
+                auto minus = parameters;
+                plus[i] += h;
+                minus[i] -= h;
+                auto numeric = (optimizer.log_loss(plus, histories) - optimizer.log_loss(minus, histories)) / (2.0 * h);
+                Assert::AreEqual(numeric, gradient[i], 1e-6 + 1e-4 * std::abs(numeric), std::format(L"Gradient mismatch for w[{}].", i).c_str());
+            }
+        }
+
+        TEST_METHOD(TestOptimizerReducesLogLoss)
+        {
+            auto histories = simulate_histories(1000, 10);
+            auto config = OptimizerConfig::get_default();
+            for (auto& p : config.initial_parameters)
+                p *= 1.5;
+            auto optimizer = Optimizer(config);
+
+            auto fitted = optimizer.fit(histories);
+            Assert::AreEqual(size_t(21), fitted.size());
+            Assert::IsTrue(optimizer.log_loss(fitted, histories) < optimizer.log_loss(config.initial_parameters, histories), L"Fitting did not reduce the loss.");
+            auto fitted_config = SchedulerConfig::get_default();
+            fitted_config.parameters = fitted;
+            auto fitted_scheduler = Scheduler(fitted_config);
+
+            auto users = std::vector<std::vector<ReviewHistory>>{ histories, histories };
+            auto per_user = optimizer.fit_users(users);
+            AssertVectorsAreEqual(fitted, per_user[0]);
+            AssertVectorsAreEqual(fitted, per_user[1]);
+        }
+
+        TEST_METHOD(TestReplayEngineMatchesSequentialReviews)
+        {
+            auto scheduler = Scheduler(SchedulerConfig::get_default(), 5);
+            auto ratings = std::uniform_int_distribution<int>(1, 4);
+            auto cards = std::uniform_int_distribution<long long>(1, 50);
+            auto gaps = std::uniform_int_distribution<long long>(0, 3 * 86400000LL);
+            auto events = std::vector<ReviewEvent>(5000);
+            auto now = timestamp_t(std::chrono::milliseconds(1700000000000LL));
+            for (auto& event : events) {
+                now += std::chrono::milliseconds(gaps(rand_gen) / 50);
+                event = { cards(rand_gen), now, static_cast<Rating>(ratings(rand_gen)) };
+            }
+
+            auto engine = ReplayEngine(scheduler);
+            for (size_t start = 0; start < events.size(); start += 700)
+                engine.push(std::span(events).subspan(start, std::min<size_t>(700, events.size() - start)));
+
+            for (auto id = 1LL; id <= 50; ++id) {
+                auto expected = Card::create(id);
+                auto last = timestamp_t{};
+                auto count = std::uint64_t{};
+                for (const auto& event : events) {
+                    if (event.card_id != id)
+                        continue;
+                    auto elapsed = (count == 0) ? days_t(0.0) : std::chrono::duration_cast<days_t>(event.timestamp - last);
+                    expected = scheduler.review_card(expected, event.rating, elapsed, count++);
+                    last = event.timestamp;
+                }
+                auto actual = engine.find(id);
+                Assert::IsTrue(actual.has_value(), L"Card missing from replay.");
+                Assert::IsTrue(expected.interval == actual->interval && expected.stability == actual->stability
+                    && expected.difficulty == actual->difficulty && expected.state == actual->state && expected.step == actual->step, L"Card mismatch.");
+            }
+            Assert::AreEqual(size_t(50), engine.size());
+
+            auto stale = ReviewEvent{ 1, events.front().timestamp, Rating::Good };
+            Assert::ExpectException<std::invalid_argument>([&]() { engine.push(stale); });
+        }
+
+        TEST_METHOD(TestCardStoreMapsColumns)
+        {
+            auto scheduler = Scheduler(SchedulerConfig::get_default(), 3);
+            auto cards = std::vector<Card>();
+            for (auto id = 1LL; id <= 1000; ++id)
+                cards.push_back(scheduler.review_card(Card::create(id), static_cast<Rating>(id % 4 + 1), days_t(0.0), 0));
+            auto path = std::filesystem::temp_directory_path() / "fsrs_card_store_test.bin";
+            CardStore::write(path, cards);
+
+            {
+                auto store = CardStore::open(path);
+                store.verify();
+                Assert::AreEqual(cards.size(), store.size());
+                for (size_t i = 0; i < cards.size(); ++i) {
+                    auto card = store.card(i);
+                    Assert::IsTrue(card.card_id == cards[i].card_id && card.interval == cards[i].interval && card.stability == cards[i].stability
+                        && card.difficulty == cards[i].difficulty && card.state == cards[i].state && card.step == cards[i].step, L"Card mismatch.");
+                }
+                Assert::ExpectException<std::logic_error>([&]() { store.columns(); });
+            }
+
+            auto ratings = std::vector<Rating>(cards.size(), Rating::Good);
+            auto intervals = std::vector<days_t>(cards.size(), days_t(1.0));
+            auto indices = std::vector<std::uint64_t>(cards.size(), 1);
+            {
+                auto store = CardStore::open(path, CardStore::Access::CopyOnWrite);
+                scheduler.review_cards(store.columns(), ratings, intervals, indices);
+                Assert::IsTrue(store.stability()[0] != cards[0].stability, L"Copy-on-write columns were not updated.");
+            }
+            Assert::IsTrue(CardStore::open(path).stability()[0] == cards[0].stability, L"Copy-on-write changes reached the file.");
+
+            {
+                auto store = CardStore::open(path, CardStore::Access::ReadWrite);
+                scheduler.review_cards(store.columns(), ratings, intervals, indices);
+                store.flush();
+            }
+            {
+                auto reopened = CardStore::open(path);
+                for (size_t i = 0; i < cards.size(); ++i) {
+                    auto expected = scheduler.review_card(cards[i], Rating::Good, days_t(1.0), 1);
+                    Assert::IsTrue(expected.stability == reopened.stability()[i] && expected.interval == reopened.interval()[i], L"Mapped review mismatch.");
+                }
+            }
+
+            auto patched = [&](std::size_t offset, auto value) {
+                auto original = std::ifstream(path, std::ios::binary);
+                auto bytes = std::vector<char>(std::istreambuf_iterator<char>(original), std::istreambuf_iterator<char>());
+                std::memcpy(bytes.data() + offset, &value, sizeof(value));
+                auto copy = std::filesystem::path(path) += std::format(".patched{}", offset);
+                std::ofstream(copy, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+                return copy;
+            };
+            auto state_offset = std::size_t{};
+            std::ifstream(path, std::ios::binary).seekg(56).read(reinterpret_cast<char*>(&state_offset), sizeof(state_offset));
+            auto oversized = patched(16, cards.size() + (std::uint64_t{ 1 } << 62));
+            Assert::ExpectException<std::invalid_argument>([&]() { CardStore::open(oversized); });
+            std::filesystem::remove(oversized);
+            auto unknown_state = patched(state_offset, std::int32_t{ 7 });
+            {
+                auto store = CardStore::open(unknown_state);
+                Assert::ExpectException<std::invalid_argument>([&]() { store.card(0); });
+                Assert::ExpectException<std::invalid_argument>([&]() { store.verify(); });
+                Assert::IsTrue(store.card(1).card_id == cards[1].card_id, L"Valid cards must still be readable.");
+            }
+            std::filesystem::remove(unknown_state);
+
+            std::ofstream(path, std::ios::binary) << "not a card store";
+            Assert::ExpectException<std::invalid_argument>([&]() { CardStore::open(path); });
+            std::filesystem::remove(path);
+        }
+
+        TEST_METHOD(TestSimulatorForecastIsReproducible)
+        {
+            auto scheduler = Scheduler(SchedulerConfig::get_default(), 9);
+            auto cards = std::vector<Card>();
+            auto elapsed = std::vector<days_t>();
+            for (auto id = 1LL; id <= 10000; ++id) {
+                auto card = scheduler.review_card(Card::create(id), Rating::Good, days_t(0.0), 0);
+                card = scheduler.review_card(card, Rating::Good, card.interval, 1);
+                cards.push_back(card);
+                elapsed.push_back(days_t(static_cast<double>(id % 3)));
+            }
+
+            auto config = SimulatorConfig::get_default();
+            config.days = 60;
+            config.runs = 3;
+            config.new_cards_per_day = 20;
+            config.seed = 17;
+            auto simulator = Simulator(scheduler, config);
+            auto first = simulator.forecast(cards, elapsed);
+            auto second = simulator.forecast(cards, elapsed);
+            AssertVectorsAreEqual(first.reviews, second.reviews);
+            AssertVectorsAreEqual(first.lapses, second.lapses);
+
+            Assert::AreEqual(size_t(60), first.reviews.size());
+            Assert::IsTrue(first.reviews[0] >= 10000.0 / 3.0, L"Overdue and due-today cards are missing from day 0.");
+            for (size_t day = 0; day < first.reviews.size(); ++day)
+                Assert::IsTrue(first.reviews[day] >= config.new_cards_per_day && first.lapses[day] <= first.reviews[day]);
+
+            config.seed = 18;
+            auto other = Simulator(scheduler, config).forecast(cards, elapsed);
+            Assert::IsTrue(other.reviews != first.reviews, L"Different seeds produced identical forecasts.");
+            config.seed = 17 + (std::uint64_t{ 1 } << 32);
+            other = Simulator(scheduler, config).forecast(cards, elapsed);
+            Assert::IsTrue(other.reviews != first.reviews, L"Seeds differing in the upper 32 bits produced identical forecasts.");
+
+            config.runs = 0;
+            Assert::ExpectException<std::invalid_argument>([&]() { Simulator(scheduler, config); });
+        }
+
+        TEST_METHOD(TestOptimizeRetention)
+        {
+            auto cards = std::vector<Card>();
+            auto elapsed = std::vector<days_t>();
+            auto simulator_config = SimulatorConfig::get_default();
+            simulator_config.days = 120;
+            simulator_config.new_cards_per_day = 10;
+            auto search = RetentionSearchConfig::get_default();
+            search.step = 0.03;
+
+            auto result = optimize_retention(SchedulerConfig::get_default(), simulator_config, search, cards, elapsed);
+            Assert::AreEqual(size_t(10), result.candidates.size());
+            Assert::IsTrue(result.desired_retention >= search.min_retention && result.desired_retention <= search.max_retention);
+            for (const auto& candidate : result.candidates) {
+                Assert::IsTrue(candidate.retained > 0.0 && candidate.reviews > 0.0);
+                Assert::IsTrue(candidate.cost >= std::ranges::min_element(result.candidates, {}, &RetentionCandidate::cost)->cost);
+            }
+            Assert::IsTrue(result.candidates.front().reviews < result.candidates.back().reviews, L"Higher retention should cost more reviews.");
+
+            search.max_retention = 1.0;
+            Assert::ExpectException<std::invalid_argument>([&]() { optimize_retention(SchedulerConfig::get_default(), simulator_config, search, cards, elapsed); });
+        }
+
+        TEST_METHOD(TestReviewPathDoesNotAllocate)
+        {
+            auto fixed = FixedSchedulerConfig::from(SchedulerConfig::get_default());
+            auto ratings = std::array{ Rating::Again, Rating::Hard, Rating::Good, Rating::Good, Rating::Easy, Rating::Good };
+            auto keyed = Scheduler(fixed, 1);
+            auto seeded = Scheduler(fixed, rand_gen);
+            auto card = Card::create(1L);
+            auto other = Card::create(2L);
+
+            count_allocations = true;
+            allocation_count = 0;
+            for (auto i = 0; i < 1000; ++i) {
+                auto scheduler = Scheduler(fixed, static_cast<std::uint64_t>(i));
+                card = scheduler.review_card(card, Rating::Good, card.interval, 0);
+            }
+            for (auto i = 0; i < 1000000; ++i) {
+                auto rating = ratings[i % ratings.size()];
+                card = keyed.review_card(card, rating, card.interval, static_cast<std::uint64_t>(i));
+                other = seeded.review_card(other, rating, other.interval);
+            }
+            count_allocations = false;
+
+            Assert::AreEqual(size_t(0), allocation_count, L"The review path allocated.");
+        }
+
+        TEST_METHOD(TestSchedulerCache)
+        {
+            auto make_config = [](int i) {
+                auto config = SchedulerConfig::get_default();
+                config.desired_retention = 0.8 + 0.001 * i;
+                return config;
+            };
+
+            auto cache = SchedulerCache(8, 4);
+            auto hot = cache.get(make_config(0));
+            Assert::IsTrue(hot == cache.get(make_config(0)), L"Repeated lookup returned a different scheduler.");
+            Assert::IsTrue(hot != cache.get(make_config(1)), L"Different configs shared a scheduler.");
+            for (auto i = 2; i < 40; ++i) {
+                cache.get(make_config(i));
+                Assert::IsTrue(hot == cache.get(make_config(0)), L"Recently used scheduler was evicted.");
+            }
+            Assert::AreEqual(cache.capacity(), cache.size());
+
+            auto shared = SchedulerCache(64, 4);
+            auto workers = std::vector<std::thread>();
+            auto mismatches = std::atomic<int>(0);
+            for (auto t = 0; t < 8; ++t) {
+                workers.emplace_back([&, t]() {
+                    for (auto i = 0; i < 2000; ++i) {
+                        auto config = make_config((i * 7 + t) % 50);
+                        auto scheduler = shared.get(config);
+                        auto expected = Scheduler(config, 4).review_card(Card::create(i), Rating::Good, days_t(0.0), 0);
+                        auto actual = scheduler->review_card(Card::create(i), Rating::Good, days_t(0.0), 0);
+                        if (expected.stability != actual.stability || expected.interval != actual.interval)
+                            ++mismatches;
+                    }
+                });
+            }
+            for (auto& worker : workers)
+                worker.join();
+            Assert::AreEqual(0, mismatches.load());
+            Assert::IsTrue(shared.size() <= shared.capacity());
+        }
+
+        TEST_METHOD(TestGeneratorFuzzing)
+        {
+            auto config = SchedulerConfig::get_default();
+            auto scheduler = Scheduler(config);
+            config.enable_fuzzing = false;
+            auto unfuzzed = Scheduler(config);
+            auto card = Card::create(1);
+            card.state = State::Review;
+            card.stability = 30.0;
+            card.difficulty = 5.0;
+            card.interval = days_t(30.0);
+
+            auto first = SplitMix64(7);
+            auto second = SplitMix64(7);
+            auto seen = std::vector<bool>(100);
+            for (auto i = 0; i < 2000; ++i) {
+                auto a = scheduler.review_card(card, Rating::Hard, days_t(30.0), first);
+                auto b = scheduler.review_card(card, Rating::Hard, days_t(30.0), second);
+                Assert::AreEqual(a.interval.count(), b.interval.count());
+
+                auto interval = unfuzzed.review_card(card, Rating::Hard, days_t(30.0), 0).interval.count();
+                auto delta = 0.15 * 4.5 + 0.1 * 13.0 + 0.05 * (interval - 20.0);
+                Assert::IsTrue(a.interval.count() >= std::round(interval - delta) && a.interval.count() <= std::round(interval + delta));
+                seen[static_cast<std::size_t>(a.interval.count())] = true;
+            }
+            Assert::IsTrue(std::count(seen.begin(), seen.end(), true) > 3, L"Fuzzing did not spread intervals.");
+
+            auto rand_gen = std::mt19937(3);
+            auto fuzzed = scheduler.review_card(card, Rating::Hard, days_t(30.0), rand_gen);
+            Assert::IsTrue(fuzzed.interval.count() >= 2.0);
+
+            for (auto days : { 0.49999999999999994, 2.5, 4.499999999999999, 7.5, 20.5, 100.49999999999999, 36500.0 }) {
+                auto delta = 0.15 * std::max(0.0, std::min(days, 7.0) - 2.5) + 0.1 * std::max(0.0, std::min(days, 20.0) - 7.0) + 0.05 * std::max(0.0, days - 20.0);
+                auto [min_days, max_days] = FsrsAlgorithm::fuzz_range(days);
+                Assert::AreEqual(static_cast<int>(std::round(days - delta)), min_days);
+                Assert::AreEqual(static_cast<int>(std::round(days + delta)), max_days);
+            }
+        }
+
+        TEST_METHOD(TestInstrumentationCounters)
+        {
+            static auto observed_cards = std::atomic<std::size_t>(0);
+            FsrsInstrumentation::set_batch_observer([](std::size_t cards, std::chrono::nanoseconds) { observed_cards += cards; });
+            FsrsInstrumentation::reset();
+
+            auto scheduler = Scheduler(SchedulerConfig::get_default());
+            auto card = scheduler.review_card(Card::create(1), Rating::Good, days_t(0.0), 0);
+            card = scheduler.review_card(card, Rating::Good, days_t(0.0), 1);
+            card = scheduler.review_card(card, Rating::Again, card.interval, 2);
+
+            auto ids = std::vector<long long>(100);
+            auto intervals = std::vector<days_t>(100);
+            auto stabilities = std::vector<double>(100);
+            auto difficulties = std::vector<double>(100);
+            auto states = std::vector<State>(100);
+            auto steps = std::vector<int>(100);
+            auto columns = CardColumns{ ids, intervals, stabilities, difficulties, states, steps };
+            auto ratings = std::vector<Rating>(100, Rating::Easy);
+            auto indices = std::vector<std::uint64_t>(100);
+            std::thread([&]() { scheduler.review_cards(columns, ratings, intervals, indices); }).join();
+
+            auto counters = FsrsInstrumentation::snapshot();
+            FsrsInstrumentation::set_batch_observer(nullptr);
+            auto index = [](State s) { return static_cast<std::size_t>(s); };
+            if constexpr (FsrsInstrumentation::enabled) {
+                Assert::AreEqual(std::uint64_t(101), counters.transitions[index(State::New)][index(State::Learning)] + counters.transitions[index(State::New)][index(State::Review)]);
+                Assert::AreEqual(std::uint64_t(1), counters.transitions[index(State::Review)][index(State::Relearning)]);
+                Assert::AreEqual(std::uint64_t(103), std::accumulate(counters.interval_histogram.begin(), counters.interval_histogram.end(), std::uint64_t{}));
+                Assert::AreEqual(std::uint64_t(1), counters.batches);
+                Assert::AreEqual(std::uint64_t(100), counters.batch_cards);
+                Assert::AreEqual(std::size_t(100), observed_cards.load());
+            }
+            else {
+                Assert::AreEqual(std::uint64_t(0), counters.batches);
+                Assert::AreEqual(std::uint64_t(0), counters.transitions[index(State::New)][index(State::Learning)]);
+                Assert::AreEqual(std::size_t(0), observed_cards.load());
+            }
+        }
+
+        TEST_METHOD(TestRetrievabilityIndexMatchesScan)
+        {
+            constexpr auto card_count = 500;
+            constexpr auto threshold = 0.9;
+            auto scheduler = Scheduler(SchedulerConfig::get_default(), 3);
+            auto index = RetrievabilityIndex(scheduler, threshold);
+            auto cards = std::vector<Card>();
+            auto last_review = std::vector<days_t>(card_count);
+            auto rating_gen = std::mt19937(11);
+            auto rating_dis = std::uniform_int_distribution<>(1, 4);
+            for (auto i = 0; i < card_count; ++i)
+                cards.push_back(Card::create(i));
+
+            for (auto day = 0; day < 120; ++day) {
+                for (auto i = 0; i < card_count; ++i) {
+                    if (cards[i].state != State::New && last_review[i] + cards[i].interval > days_t(day))
+                        continue;
+                    cards[i] = index.review_card(cards[i], static_cast<Rating>(rating_dis(rating_gen)), days_t(day), static_cast<std::uint64_t>(day));
+                    last_review[i] = days_t(day);
+                }
+            }
+            Assert::AreEqual(std::size_t(card_count), index.size());
+
+            auto now = days_t(130.0);
+            auto expected = std::vector<std::pair<days_t, long long>>();
+            for (auto i = 0; i < card_count; ++i)
+                expected.emplace_back(last_review[i] + scheduler.time_to_retrievability(cards[i].stability, threshold), i);
+            std::sort(expected.begin(), expected.end());
+
+            auto at_risk = index.at_risk(now, 50);
+            Assert::AreEqual(std::size_t(50), at_risk.size());
+            for (std::size_t k = 0; k < at_risk.size(); ++k) {
+                auto id = at_risk[k].card_id;
+                Assert::AreEqual(expected[k].second, id);
+                Assert::AreEqual(scheduler.get_retrievability(cards[id], now - last_review[id]), at_risk[k].retrievability, 1e-12);
+                if (k > 0 && at_risk[k].retrievability < threshold)
+                    Assert::IsTrue(at_risk[k - 1].retrievability < threshold, L"A card above the threshold preceded one below it.");
+            }
+
+            auto first = at_risk.front().card_id;
+            cards[first] = index.review_card(cards[first], Rating::Easy, now, 200);
+            Assert::IsTrue(first != index.at_risk(now, 1).front().card_id, L"Reviewed card kept its position.");
+            index.erase(first);
+            Assert::AreEqual(std::size_t(card_count - 1), index.size());
+            Assert::ExpectException<std::invalid_argument>([&]() { RetrievabilityIndex(scheduler, 1.0); });
+        }
+
+        TEST_METHOD(TestDueQueueServesDueCards)
+        {
+            constexpr auto card_count = 300;
+            auto scheduler = Scheduler(SchedulerConfig::get_default(), 5);
+            auto queue = DueQueue();
+            auto cards = std::vector<Card>();
+            auto due = std::vector<days_t>(card_count);
+            auto queued = std::vector<bool>(card_count, true);
+            for (auto i = 0; i < card_count; ++i) {
+                cards.push_back(Card::create(i));
+                queue.push(cards[i], days_t(0.0));
+            }
+
+            auto rating_gen = std::mt19937(13);
+            auto rating_dis = std::uniform_int_distribution<>(1, 4);
+            auto review_index = std::uint64_t{};
+            for (auto now = days_t(0.0); now < days_t(400.0); now += minutes_t(5.0)) {
+                auto served = std::vector<long long>();
+                while (auto card_id = queue.pop_due(now)) {
+                    auto& card = cards[*card_id];
+                    Assert::IsTrue(queued[*card_id], L"Served a card that was not queued.");
+                    if (card.state == State::Learning || card.state == State::Relearning)
+                        Assert::IsTrue(minutes_t(due[*card_id]).count() <= minutes_t(now).count() + 1e-6, L"Served a learning card early.");
+                    else
+                        Assert::IsTrue(std::floor(due[*card_id].count()) <= now.count() + 1e-9, L"Served a review card before its day.");
+                    queued[*card_id] = false;
+                    served.push_back(*card_id);
+                }
+                for (auto i = 0; i < card_count; ++i) {
+                    if (!queued[i])
+                        continue;
+                    auto learning = cards[i].state == State::Learning || cards[i].state == State::Relearning;
+                    auto overdue = learning ? minutes_t(due[i]).count() < minutes_t(now).count() - 1e-6 : std::floor(due[i].count()) < std::floor(now.count() + 1e-9);
+                    Assert::IsFalse(overdue, L"A due card was left in the queue.");
+                }
+                for (auto card_id : served) {
+                    cards[card_id] = scheduler.review_card(cards[card_id], static_cast<Rating>(rating_dis(rating_gen)), cards[card_id].interval, review_index++);
+                    due[card_id] = now + cards[card_id].interval;
+                    queue.push(cards[card_id], now);
+                    queued[card_id] = true;
+                }
+            }
+            Assert::AreEqual(std::size_t(card_count), queue.size());
+
+            queue.push(cards[0], days_t(10000.0));
+            queue.erase(1);
+            auto remaining = std::vector<long long>();
+            while (auto card_id = queue.pop_due(days_t(5000.0)))
+                remaining.push_back(*card_id);
+            Assert::AreEqual(std::size_t(card_count - 2), remaining.size());
+            Assert::IsTrue(std::ranges::find(remaining, 0) == remaining.end() && std::ranges::find(remaining, 1) == remaining.end());
+            Assert::AreEqual(std::size_t(1), queue.size());
+            Assert::AreEqual(0LL, queue.pop_due(days_t(20000.0)).value_or(-1));
+        }
+
+        TEST_METHOD(TestReviewPipelineBatchesRequests)
+        {
+            constexpr auto producers = 8;
+            constexpr auto requests_per_producer = 2000;
+            auto scheduler = Scheduler(SchedulerConfig::get_default(), 9);
+            auto written = std::vector<Card>();
+            auto sink_mutex = std::mutex();
+            auto sink = [&](std::span<const Card> cards) {
+                auto lock = std::scoped_lock(sink_mutex);
+                written.insert(written.end(), cards.begin(), cards.end());
+            };
+
+            auto make_request = [](int id) {
+                auto card = Card::create(id);
+                card.state = State::Review;
+                card.stability = 1.0 + id % 97;
+                card.difficulty = 1.0 + id % 9;
+                card.interval = days_t(card.stability);
+                return ReviewRequest{ card, static_cast<Rating>(1 + id % 4), card.interval, static_cast<std::uint64_t>(id) };
+            };
+
+            auto mismatches = std::atomic<int>(0);
+            auto awaited = std::atomic<int>(0);
+            {
+                auto pipeline = ReviewPipeline(scheduler, sink);
+                auto threads = std::vector<std::thread>();
+                for (auto t = 0; t < producers; ++t) {
+                    threads.emplace_back([&, t]() {
+                        auto futures = std::vector<std::pair<int, std::future<Card>>>();
+                        for (auto i = 0; i < requests_per_producer; ++i) {
+                            auto id = t * requests_per_producer + i;
+                            futures.emplace_back(id, pipeline.submit(make_request(id)));
+                        }
+                        for (auto& [id, future] : futures) {
+                            auto request = make_request(id);
+                            auto expected = scheduler.review_card(request.card, request.rating, request.review_interval, request.review_index);
+                            auto actual = future.get();
+                            if (actual.interval != expected.interval || actual.stability != expected.stability || actual.state != expected.state)
+                                ++mismatches;
+                        }
+                    });
+                }
+                for (auto& thread : threads)
+                    thread.join();
+
+                auto coroutine = [&](ReviewRequest request) -> DetachedTask {
+                    auto card = co_await pipeline.review(request);
+                    card = co_await pipeline.review({ card, Rating::Good, card.interval, request.review_index + 1 });
+                    if (card.state == State::Review)
+                        ++awaited;
+                };
+                for (auto i = 0; i < 10; ++i)
+                    coroutine(make_request(100000 + i));
+                while (awaited.load() < 10)
+                    std::this_thread::yield();
+
+                Assert::IsTrue(pipeline.batches() < static_cast<std::uint64_t>(producers * requests_per_producer), L"Requests were not coalesced.");
+            }
+
+            Assert::AreEqual(0, mismatches.load());
+            Assert::AreEqual(10, awaited.load());
+            Assert::AreEqual(std::size_t(producers * requests_per_producer + 20), written.size());
+        }
+
+        TEST_METHOD(TestPmrCollectionsUseArena)
+        {
+            constexpr auto card_count = 1000;
+            auto buffer = std::vector<std::byte>(1 << 22);
+            auto arena = std::pmr::monotonic_buffer_resource(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+
+            auto config = pmr::SchedulerConfig::get_default(&arena);
+            Assert::IsTrue(config.parameters.get_allocator().resource() == &arena);
+            Assert::IsTrue(FixedSchedulerConfig::from(config) == FixedSchedulerConfig::from(SchedulerConfig::get_default()));
+
+            auto scheduler = Scheduler(config, 3);
+            auto reference = Scheduler(SchedulerConfig::get_default(), 3);
+            auto cards = std::vector<Card>();
+            for (auto i = 0; i < card_count; ++i)
+                cards.push_back(reference.review_card(Card::create(i), static_cast<Rating>(1 + i % 4), days_t(0.0), 0));
+
+            auto table = pmr::CardTable(cards, &arena);
+            auto ratings = std::pmr::vector<Rating>(card_count, Rating::Good, &arena);
+            auto intervals = std::pmr::vector<days_t>(card_count, days_t(1.0), &arena);
+            auto indices = std::pmr::vector<std::uint64_t>(card_count, 1, &arena);
+            scheduler.review_cards(table.columns(), ratings, intervals, indices);
+            auto reviewed = table.to_cards();
+            for (auto i = 0; i < card_count; ++i) {
+                auto expected = reference.review_card(cards[i], Rating::Good, days_t(1.0), 1);
+                Assert::IsTrue(expected.interval == reviewed[i].interval && expected.stability == reviewed[i].stability && expected.state == reviewed[i].state);
+            }
+
+            auto simulator_config = SimulatorConfig::get_default();
+            simulator_config.days = 60;
+            auto simulator = Simulator(reference, simulator_config);
+            auto elapsed = std::vector<days_t>(card_count);
+            auto pooled = simulator.forecast(cards, elapsed, &arena);
+            auto plain = simulator.forecast(cards, elapsed);
+            Assert::IsTrue(pooled.reviews == plain.reviews && pooled.seconds == plain.seconds);
+
+            Assert::ExpectException<std::bad_alloc>([&]() { pmr::CardTable(std::vector<Card>(1 << 20), &arena); });
+        }
+
+        TEST_METHOD(TestIntervalTableMatchesNextInterval)
+        {
+            for (auto [retention, maximum_interval] : { std::pair{ 0.9, 36500 }, std::pair{ 0.8, 365 }, std::pair{ 0.97, 2 }, std::pair{ 0.75, 1 } }) {
+                auto config = SchedulerConfig::get_default();
+                config.desired_retention = retention;
+                config.maximum_interval = maximum_interval;
+                auto scheduler = Scheduler(config);
+                auto table = scheduler.interval_table();
+                Assert::AreEqual(maximum_interval, table.maximum_interval());
+
+                auto stability = std::vector<double>();
+                auto rand_gen = std::mt19937(17);
+                auto exponent = std::uniform_real_distribution<>(-3.0, 6.0);
+                for (auto i = 0; i < 100000; ++i)
+                    stability.push_back(std::pow(10.0, exponent(rand_gen)));
+                for (auto days = 2; days <= maximum_interval; days += 37) {
+                    auto threshold = table.minimum_stability(days);
+                    stability.insert(stability.end(), { threshold, std::nextafter(threshold, 0.0), std::nextafter(threshold, 1e300) });
+                }
+                stability.insert(stability.end(), { 0.0, FsrsAlgorithm::STABILITY_MIN, 1e300, std::numeric_limits<double>::infinity() });
+
+                auto intervals = std::vector<days_t>(stability.size());
+                table.lookup(stability, intervals);
+                for (std::size_t i = 0; i < stability.size(); ++i)
+                    Assert::AreEqual(scheduler.calculate_next_review_interval(stability[i]).count(), intervals[i].count());
+            }
+
+            auto config = SchedulerConfig::get_default();
+            config.maximum_interval = IntervalTable::MAX_DAYS;
+            auto largest = Scheduler(config).interval_table();
+            Assert::AreEqual(IntervalTable::MAX_DAYS, largest.maximum_interval());
+            Assert::AreEqual(static_cast<double>(IntervalTable::MAX_DAYS), largest(1e300).count());
+            config.maximum_interval = std::numeric_limits<int>::max();
+            Assert::ExpectException<std::invalid_argument>([&]() { Scheduler(config).interval_table(); });
+        }
+
+        TEST_METHOD(TestFloatPrecisionDrift)
+        {
+            auto config = FsrsCpp::SchedulerConfig(SchedulerConfig::get_default());
+            config.learning_steps.clear();
+            config.relearning_steps.clear();
+            config.enable_fuzzing = false;
+            auto scheduler = Scheduler(config);
+
+            auto card = Card::create(1L);
+            auto float_card = FloatCard::create(1L);
+            for (auto rating : { Rating::Again, Rating::Good, Rating::Good, Rating::Good, Rating::Good, Rating::Good }) {
+                auto review_interval = card.interval;
+                card = scheduler.review_card(card, rating, review_interval, 0);
+                float_card = scheduler.review_card(float_card, rating, review_interval, 0);
+                Assert::AreEqual(card.interval.count(), static_cast<double>(float_card.interval.count()));
+            }
+
+            auto random_scheduler = Scheduler(SchedulerConfig::get_default(), 7);
+            auto history_gen = std::mt19937(42);
+            auto rating_dist = std::discrete_distribution<>({ 10, 5, 80, 5 });
+            auto lateness_dist = std::uniform_real_distribution<>(0.5, 2.0);
+            auto max_stability_drift = 0.0;
+            auto max_difficulty_drift = 0.0;
+            auto max_interval_drift = 0.0;
+            auto matches = 0;
+            auto total = 0;
+            for (long long id = 0; id < 2000; ++id) {
+                auto exact = Card::create(id);
+                auto single = FloatCard::create(id);
+                for (std::uint64_t index = 0; index < 50; ++index) {
+                    auto rating = static_cast<Rating>(rating_dist(history_gen) + 1);
+                    auto review_interval = days_t(std::round(exact.interval.count() * lateness_dist(history_gen)));
+                    exact = random_scheduler.review_card(exact, rating, review_interval, index);
+                    single = random_scheduler.review_card(single, rating, review_interval, index);
+                    max_stability_drift = std::max(max_stability_drift, std::abs(single.stability - exact.stability) / exact.stability);
+                    max_difficulty_drift = std::max(max_difficulty_drift, std::abs(single.difficulty - exact.difficulty));
+                    max_interval_drift = std::max(max_interval_drift, std::abs(single.interval.count() - exact.interval.count()));
+                    matches += (static_cast<float>(exact.interval.count()) == single.interval.count() && exact.state == single.state) ? 1 : 0;
+                    ++total;
+                }
+            }
+
+            auto match_rate = static_cast<double>(matches) / total;
+            Logger::WriteMessage(std::format("float drift: stability {:.3g} relative, difficulty {:.3g}, interval {} days, intervals matched {:.4f}%\n", max_stability_drift, max_difficulty_drift, max_interval_drift, 100.0 * match_rate).c_str());
+            Assert::IsTrue(max_stability_drift < 1e-4);
+            Assert::IsTrue(max_difficulty_drift < 1e-4);
+            Assert::IsTrue(max_interval_drift <= 2.0);
+            Assert::IsTrue(match_rate > 0.99);
+        }
+
+        TEST_METHOD(TestImportCardsMatchesReviewCard)
+        {
+            constexpr auto card_count = std::size_t{ 10007 };
+            constexpr auto first_id = 1000LL;
+            auto scheduler = Scheduler(SchedulerConfig::get_default(), 3);
+            auto table = pmr::CardTable();
+            table.resize(card_count);
+            auto rating_gen = std::mt19937(17);
+            auto ratings = std::vector<Rating>(card_count);
+            for (auto& rating : ratings) {
+                rating = static_cast<Rating>(std::uniform_int_distribution<>(1, 4)(rating_gen));
+            }
+
+            scheduler.import_cards(table.columns(), first_id, ratings, 5);
+
+            for (std::size_t i = 0; i < card_count; ++i) {
+                auto expected = scheduler.review_card(Card::create(first_id + static_cast<long long>(i)), ratings[i], days_t(0.0), 5);
+                auto actual = table.card(i);
+                Assert::AreEqual(expected.card_id, actual.card_id);
+                Assert::AreEqual(expected.interval.count(), actual.interval.count());
+                Assert::AreEqual(expected.stability, actual.stability);
+                Assert::AreEqual(expected.difficulty, actual.difficulty);
+                Assert::IsTrue(expected.state == actual.state, L"State mismatch.");
+                Assert::AreEqual(expected.step, actual.step);
+            }
+
+            Assert::ExpectException<std::invalid_argument>([&]() { scheduler.import_cards(table.columns(), first_id, std::span(ratings).first(10)); });
+        }
+
+        TEST_METHOD(TestEvaluatorMatchesLogLoss)
+        {
+            auto histories = simulate_histories(500, 8);
+            auto configs = std::vector<SchedulerConfig>(3, SchedulerConfig::get_default());
+            for (auto& p : configs[1].parameters)
+                p *= 1.2;
+            configs[2].desired_retention = 0.8;
+            auto evaluator = Evaluator(configs);
+            auto optimizer = Optimizer(OptimizerConfig::get_default());
+
+            auto metrics = evaluator.evaluate(histories);
+            Assert::AreEqual(configs.size(), metrics.size());
+            for (size_t k = 0; k < configs.size(); ++k) {
+                Assert::AreEqual(optimizer.log_loss(configs[k].parameters, histories), metrics[k].log_loss, 1e-12, L"Log-loss differs from the optimizer.");
+                Assert::IsTrue(metrics[k].rmse > 0.0 && metrics[k].rmse < 1.0, L"RMSE out of range.");
+                Assert::AreEqual(metrics[0].count, metrics[k].count);
+            }
+            Assert::IsTrue(metrics[0].log_loss < metrics[1].log_loss, L"Perturbed parameters should score worse.");
+            Assert::AreEqual(metrics[0].log_loss, metrics[2].log_loss);
+            Assert::AreEqual(metrics[0].rmse, metrics[2].rmse);
+            Assert::ExpectException<std::invalid_argument>([] { Evaluator(std::span<const SchedulerConfig>()); });
+        }
+
+        TEST_METHOD(TestServiceRecoversFromSnapshotAndLog)
+        {
+            auto scheduler = Scheduler(SchedulerConfig::get_default(), 5);
+            auto ratings = std::uniform_int_distribution<int>(1, 4);
+            auto cards = std::uniform_int_distribution<long long>(1, 200);
+            auto gaps = std::uniform_int_distribution<long long>(0, 3 * 86400000LL);
+            auto events = std::vector<ReviewEvent>(6000);
+            auto now = timestamp_t(std::chrono::milliseconds(1700000000000LL));
+            for (auto& event : events) {
+                now += std::chrono::milliseconds(gaps(rand_gen) / 200);
+                event = { cards(rand_gen), now, static_cast<Rating>(ratings(rand_gen)) };
+            }
+            auto expected = ReplayEngine(scheduler);
+            expected.push(events);
+            auto matches = [&](auto&& find) {
+                for (auto id = 1LL; id <= 200; ++id) {
+                    auto want = expected.find(id);
+                    auto got = find(id);
+                    if (want.has_value() != got.has_value())
+                        return false;
+                    if (want && !(want->interval == got->interval && want->stability == got->stability && want->difficulty == got->difficulty
+                        && want->state == got->state && want->step == got->step))
+                        return false;
+                }
+                return true;
+            };
+
+            auto directory = std::filesystem::temp_directory_path() / "fsrs_service_test";
+            std::filesystem::remove_all(directory);
+            auto events_span = std::span<const ReviewEvent>(events);
+            auto half = events.size() / 2;
+            {
+                auto shard = ReviewShard(directory / "single", scheduler);
+                shard.apply(events_span.first(half));
+                shard.snapshot();
+                shard.apply(events_span.subspan(half, 1000));
+            }
+            for (const auto& entry : std::filesystem::directory_iterator(directory / "single"))
+                if (entry.path().extension() == ".wal")
+                    std::ofstream(entry.path(), std::ios::binary | std::ios::app) << "torn";
+            auto leftover = directory / "single" / "snapshot-00000000000000009999.cards.tmp";
+            std::ofstream(leftover, std::ios::binary) << "partial";
+            {
+                auto shard = ReviewShard(directory / "single", scheduler);
+                Assert::AreEqual(std::uint64_t(half), shard.snapshot_sequence());
+                Assert::AreEqual(std::uint64_t(half + 1000), shard.sequence());
+                Assert::IsFalse(std::filesystem::exists(leftover), L"Leftover snapshot file was not removed.");
+                auto stale = ReviewEvent{ events[half].card_id, events.front().timestamp - std::chrono::hours(1), Rating::Good };
+                Assert::ExpectException<std::invalid_argument>([&]() { shard.apply(std::span(&stale, 1)); });
+                Assert::AreEqual(std::uint64_t(half + 1000), shard.sequence());
+                shard.apply(events_span.subspan(half + 1000));
+            }
+            {
+                auto shard = ReviewShard(directory / "single", scheduler);
+                Assert::AreEqual(std::uint64_t(events.size()), shard.sequence());
+                Assert::IsTrue(matches([&](long long id) { return shard.find(id); }), L"Recovered shard differs from the replay.");
+            }
+
+            auto config = ServiceConfig::get_default();
+            config.directory = directory / "service";
+            config.shard_count = 4;
+            config.snapshot_interval = 500;
+            config.sync_log = false;
+            {
+                auto service = ShardedService(scheduler, config);
+                for (size_t start = 0; start < events.size(); start += 700)
+                    service.submit(events_span.subspan(start, std::min<size_t>(700, events.size() - start))).get();
+                Assert::IsTrue(matches([&](long long id) { return service.find(id).get(); }), L"Service differs from the replay.");
+                Assert::ExpectException<std::invalid_argument>([&]() { service.submit(events_span.first(1)).get(); });
+            }
+            {
+                auto service = ShardedService(scheduler, config);
+                Assert::IsTrue(matches([&](long long id) { return service.find(id).get(); }), L"Restarted service differs from the replay.");
+            }
+            config.shard_count = 3;
+            Assert::ExpectException<std::invalid_argument>([&]() { ShardedService(scheduler, config); });
+            std::filesystem::remove_all(directory);
+        }
+
+        TEST_METHOD(TestExecutionPathsAreReproducible)
+        {
+            constexpr auto card_count = 20000;
+            constexpr auto rounds = 24;
+            const auto scheduler = Scheduler(SchedulerConfig::get_default(), 31);
+            auto rating_dis = std::discrete_distribution<int>({ 0.10, 0.15, 0.65, 0.10 });
+            auto delay_dis = std::uniform_real_distribution<double>(0.5, 2.0);
+            auto ratings = std::vector<std::vector<Rating>>(rounds, std::vector<Rating>(card_count));
+            auto delays = std::vector<std::vector<double>>(rounds, std::vector<double>(card_count));
+            for (auto r = 0; r < rounds; ++r) {
+                for (auto i = 0; i < card_count; ++i) {
+                    ratings[r][i] = static_cast<Rating>(rating_dis(rand_gen) + 1);
+                    delays[r][i] = delay_dis(rand_gen);
+                }
+            }
+            auto gap = [&](days_t interval, int r, int i) {
+                return std::chrono::round<std::chrono::milliseconds>(interval * delays[r][i]);
+            };
+            auto elapsed = [&](days_t interval, int r, int i) { return std::chrono::duration_cast<days_t>(gap(interval, r, i)); };
+
+            struct Deck {
+                std::vector<long long> id = std::vector<long long>(card_count);
+                std::vector<days_t> interval = std::vector<days_t>(card_count);
+                std::vector<double> stability = std::vector<double>(card_count);
+                std::vector<double> difficulty = std::vector<double>(card_count);
+                std::vector<State> state = std::vector<State>(card_count);
+                std::vector<int> step = std::vector<int>(card_count);
+                Deck() { std::iota(id.begin(), id.end(), 0LL); }
+                auto columns(std::size_t first, std::size_t count) -> CardColumns {
+                    return { std::span(id).subspan(first, count), std::span(interval).subspan(first, count), std::span(stability).subspan(first, count),
+                        std::span(difficulty).subspan(first, count), std::span(state).subspan(first, count), std::span(step).subspan(first, count) };
+                }
+                auto card(std::size_t i) const -> Card { return { id[i], interval[i], stability[i], difficulty[i], state[i], step[i] }; }
+            };
+
+            auto serial = std::vector<Card>(card_count);
+            auto replay_card = [&](int i) {
+                auto card = Card::create(i);
+                for (auto r = 0; r < rounds; ++r)
+                    card = scheduler.review_card(card, ratings[r][i], elapsed(card.interval, r, i), static_cast<std::uint64_t>(r));
+                return card;
+            };
+            for (auto i = 0; i < card_count; ++i)
+                serial[i] = replay_card(i);
+
+            auto review_rounds = [&](Deck& deck, std::size_t first, std::size_t count) {
+                auto columns = deck.columns(first, count);
+                auto round_ratings = std::vector<Rating>(count);
+                auto round_elapsed = std::vector<days_t>(count);
+                for (auto r = 0; r < rounds; ++r) {
+                    for (std::size_t k = 0; k < count; ++k) {
+                        auto i = static_cast<int>(first + k);
+                        round_ratings[k] = ratings[r][i];
+                        round_elapsed[k] = elapsed(columns.interval[k], r, i);
+                    }
+                    scheduler.review_cards(columns, round_ratings, round_elapsed, std::vector<std::uint64_t>(count, static_cast<std::uint64_t>(r)));
+                }
+            };
+
+            auto batched = Deck();
+            review_rounds(batched, 0, card_count);
+
+            auto threaded = Deck();
+            auto interleaved = std::vector<Card>(card_count);
+            {
+                auto threads = std::vector<std::thread>();
+                for (auto t = 0; t < 8; ++t) {
+                    threads.emplace_back([&, t]() { review_rounds(threaded, t * card_count / 8, card_count / 8); });
+                    threads.emplace_back([&, t]() {
+                        for (auto i = card_count - 1 - t; i >= 0; i -= 8)
+                            interleaved[i] = replay_card(i);
+                    });
+                }
+                for (auto& thread : threads)
+                    thread.join();
+            }
+
+            auto events = std::vector<ReviewEvent>();
+            auto start = timestamp_t(std::chrono::milliseconds(1700000000000LL));
+            auto clocks = std::vector<timestamp_t>(card_count, start);
+            auto cards = std::vector<Card>(card_count);
+            for (auto i = 0; i < card_count; ++i)
+                cards[i] = Card::create(i);
+            for (auto r = 0; r < rounds; ++r) {
+                auto round = std::vector<ReviewEvent>(card_count);
+                for (auto i = 0; i < card_count; ++i) {
+                    clocks[i] += gap(cards[i].interval, r, i);
+                    round[i] = { i, clocks[i], ratings[r][i] };
+                    cards[i] = scheduler.review_card(cards[i], ratings[r][i], elapsed(cards[i].interval, r, i), static_cast<std::uint64_t>(r));
+                }
+                std::shuffle(round.begin(), round.end(), rand_gen);
+                events.insert(events.end(), round.begin(), round.end());
+            }
+            auto parallel_replay = ReplayEngine(scheduler, ReplayExecution::Parallel);
+            auto sequential_replay = ReplayEngine(scheduler, ReplayExecution::Sequential);
+            for (std::size_t first = 0; first < events.size(); first += 7777) {
+                auto chunk = std::span(events).subspan(first, std::min<std::size_t>(7777, events.size() - first));
+                parallel_replay.push(chunk);
+                sequential_replay.push(chunk);
+            }
+
+            auto same = [](const Card& a, const Card& b) {
+                return a.card_id == b.card_id && a.interval == b.interval && a.stability == b.stability && a.difficulty == b.difficulty && a.state == b.state && a.step == b.step;
+            };
+            auto fuzzed = 0;
+            for (auto i = 0; i < card_count; ++i) {
+                Assert::IsTrue(same(serial[i], batched.card(i)), L"Batched reviews differ from serial reviews.");
+                Assert::IsTrue(same(serial[i], threaded.card(i)), L"Multithreaded batches differ from serial reviews.");
+                Assert::IsTrue(same(serial[i], interleaved[i]), L"Multithreaded reviews differ from serial reviews.");
+                Assert::IsTrue(same(serial[i], cards[i]), L"Round-ordered reviews differ from serial reviews.");
+                Assert::IsTrue(same(serial[i], parallel_replay.find(i).value()), L"Parallel replay differs from serial reviews.");
+                Assert::IsTrue(same(serial[i], sequential_replay.find(i).value()), L"Sequential replay differs from serial reviews.");
+                fuzzed += serial[i].interval != scheduler.calculate_next_review_interval(serial[i].stability) ? 1 : 0;
+            }
+            Assert::IsTrue(fuzzed > card_count / 4, L"Too few fuzzed intervals to exercise the fuzz draws.");
+        }
+
         TEST_METHOD(TestStabilityLowerBound)
         {
             auto scheduler = Scheduler(SchedulerConfig::get_default(), rand_gen);
@@ -0,0 +1,130 @@
+#pragma once
+
+// Stand-in for the subset of the Visual Studio CppUnitTest framework used by the tests,
+// so the same sources run under CTest on platforms without it.
+
+#include <cstdio>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Microsoft::VisualStudio::CppUnitTestFramework
+{
+    struct Failure
+    {
+        std::wstring message;
+    };
+
+    struct TestCase
+    {
+        const char* name;
+        std::function<void()> run;
+    };
+
+    inline auto test_cases() -> std::vector<TestCase>&
+    {
+        static auto cases = std::vector<TestCase>();
+        return cases;
+    }
+
+    template<typename T>
+    class TestClass
+    {
+    protected:
+        using ThisClass = T;
+    };
+
+    class Assert
+    {
+    public:
+        template<typename T>
+        static auto AreEqual(const T& expected, const T& actual, const wchar_t* message = nullptr) -> void
+        {
+            if (!(expected == actual)) {
+                if constexpr (std::is_arithmetic_v<T>) {
+                    fail(L"expected " + std::to_wstring(expected) + L", actual " + std::to_wstring(actual), message);
+                }
+                else {
+                    fail(L"values differ", message);
+                }
+            }
+        }
+
+        static auto AreEqual(double expected, double actual, double tolerance, const wchar_t* message = nullptr) -> void
+        {
+            if (!(std::abs(expected - actual) <= tolerance)) {
+                fail(L"expected " + std::to_wstring(expected) + L", actual " + std::to_wstring(actual), message);
+            }
+        }
+
+        static auto AreEqual(float expected, float actual, float tolerance, const wchar_t* message = nullptr) -> void
+        {
+            AreEqual(static_cast<double>(expected), static_cast<double>(actual), static_cast<double>(tolerance), message);
+        }
+
+        static auto IsTrue(bool condition, const wchar_t* message = nullptr) -> void
+        {
+            if (!condition) {
+                fail(L"expected true", message);
+            }
+        }
+
+        static auto IsFalse(bool condition, const wchar_t* message = nullptr) -> void
+        {
+            if (condition) {
+                fail(L"expected false", message);
+            }
+        }
+
+        static auto Fail(const wchar_t* message = nullptr) -> void
+        {
+            fail(L"failed", message);
+        }
+
+        template<typename E, typename F>
+        static auto ExpectException(F functor, const wchar_t* message = nullptr) -> void
+        {
+            try {
+                functor();
+            }
+            catch (const E&) {
+                return;
+            }
+            catch (...) {
+            }
+            fail(L"expected exception was not thrown", message);
+        }
+
+    private:
+        static auto fail(std::wstring reason, const wchar_t* message) -> void
+        {
+            if (message != nullptr) {
+                reason = std::wstring(message) + L" (" + reason + L")";
+            }
+            throw Failure{ std::move(reason) };
+        }
+    };
+
+    class Logger
+    {
+    public:
+        static auto WriteMessage(const char* message) -> void { std::printf("%s", message); }
+        static auto WriteMessage(const wchar_t* message) -> void { std::printf("%ls", message); }
+    };
+}
+
+#define TEST_CLASS(className) \
+    class className : public ::Microsoft::VisualStudio::CppUnitTestFramework::TestClass<className>
+
+#define TEST_METHOD(methodName) \
+    struct methodName##Registrar \
+    { \
+        methodName##Registrar() \
+        { \
+            ::Microsoft::VisualStudio::CppUnitTestFramework::test_cases().push_back({ #methodName, [] { ThisClass instance; instance.methodName(); } }); \
+        } \
+    }; \
+    inline static methodName##Registrar methodName##_registrar{}; \
+    void methodName()
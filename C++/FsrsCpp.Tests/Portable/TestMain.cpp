@@ -0,0 +1,46 @@
+#include "CppUnitTest.h"
+#include <cstdio>
+#include <cstring>
+#include <exception>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+// Runs every registered test, or only those named on the command line.
+auto main(int argc, char** argv) -> int
+{
+    auto selected = [&](const char* name) {
+        if (argc < 2) {
+            return true;
+        }
+        for (auto i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    auto failed = 0;
+    auto ran = 0;
+    for (const auto& test : test_cases()) {
+        if (!selected(test.name)) {
+            continue;
+        }
+        ++ran;
+        try {
+            test.run();
+            std::printf("PASS %s\n", test.name);
+        }
+        catch (const Failure& failure) {
+            ++failed;
+            std::printf("FAIL %s: %ls\n", test.name, failure.message.c_str());
+        }
+        catch (const std::exception& e) {
+            ++failed;
+            std::printf("FAIL %s: unhandled exception: %s\n", test.name, e.what());
+        }
+    }
+
+    std::printf("%d of %d tests passed\n", ran - failed, ran);
+    return (failed == 0 && ran > 0) ? 0 : 1;
+}
@@ -1,14 +1,37 @@
+module;
+
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <span>
+#include <numeric>
+#include <stdexcept>
+#include <algorithm>
+#include <concepts>
+#include <array>
+#include <cstdint>
+#include <execution>
+#include <utility>
+#include <initializer_list>
+#include <memory_resource>
+#include <limits>
+#include <type_traits>
+
 export module FsrsCpp;
 
-import <vector>;
-import <chrono>;
-import <cmath>;
-import <random>;
-import <span>;
-import <numeric>;
-import <stdexcept>;
-import <algorithm>;
-import <concepts>;
+export import :Simd;
+export import :Instrumentation;
+
+namespace FsrsAlgorithm {
+
+    // SplitMix64 output finalizer, shared by the generator, the counter-based fuzz and the cache hashing.
+    export constexpr auto mix_bits(std::uint64_t x) -> std::uint64_t {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+        return x ^ (x >> 31);
+    }
+}
 
 export namespace FsrsCpp {
 
@@ -17,15 +40,56 @@ export namespace FsrsCpp {
 
     enum class Rating { Again = 1, Hard, Good, Easy };
     enum class State { New, Learning, Review, Relearning };
+    enum class BatchMode { Exact, Vectorized };
 
-    struct Card {
+    template<std::floating_point Real>
+    struct BasicCard {
         long long card_id{};
-        days_t interval{};
-        double stability{};
-        double difficulty{};
+        std::chrono::duration<Real, std::ratio<86400>> interval{};
+        Real stability{};
+        Real difficulty{};
         State state{ State::New };
         int step{};
-        static Card create(long long id);
+        static auto create(long long id) -> BasicCard { return { id }; }
+    };
+
+    using Card = BasicCard<double>;
+    using FloatCard = BasicCard<float>;
+
+    class PackedCard {
+    public:
+        static auto from_card(const Card& card) -> PackedCard;
+        auto to_card() const -> Card;
+
+    private:
+        static constexpr int ID_BITS = 48;
+        static constexpr int INTERVAL_BITS = 22;
+        static constexpr std::uint32_t SECONDS_FLAG = 1u << (INTERVAL_BITS - 1);
+        static constexpr double DIFFICULTY_SCALE = 65535.0 / 10.0;
+        std::uint64_t id_difficulty{};
+        float stability{};
+        std::uint32_t schedule{};
+    };
+
+    static_assert(sizeof(PackedCard) == 16);
+
+    struct CardColumns {
+        std::span<long long> card_id;
+        std::span<days_t> interval;
+        std::span<double> stability;
+        std::span<double> difficulty;
+        std::span<State> state;
+        std::span<int> step;
+        auto size() const -> std::size_t { return card_id.size(); }
+    };
+
+    struct DefaultSchedulerParams {
+        static constexpr std::array<double, 21> parameters = { 0.212, 1.2931, 2.3065, 8.2956, 6.4133, 0.8334, 3.0194, 0.001, 1.8722, 0.1666, 0.796, 1.4835, 0.0614, 0.2629, 1.6483, 0.6014, 1.8729, 0.5425, 0.0912, 0.0658, 0.1542 };
+        static constexpr double desired_retention = 0.9;
+        static constexpr std::array<days_t, 2> learning_steps = { minutes_t(1.0), minutes_t(10.0) };
+        static constexpr std::array<days_t, 1> relearning_steps = { minutes_t(10.0) };
+        static constexpr int maximum_interval = 36500;
+        static constexpr bool enable_fuzzing = true;
     };
 
     struct SchedulerConfig {
@@ -38,244 +102,974 @@ export namespace FsrsCpp {
         static const SchedulerConfig& get_default();
     };
 
+    namespace pmr {
+        struct SchedulerConfig {
+            std::pmr::vector<double> parameters;
+            double desired_retention;
+            std::pmr::vector<days_t> learning_steps;
+            std::pmr::vector<days_t> relearning_steps;
+            int maximum_interval;
+            bool enable_fuzzing;
+            static auto get_default(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) -> SchedulerConfig;
+        };
+
+        using CardVector = std::pmr::vector<Card>;
+
+        class CardTable {
+        public:
+            explicit CardTable(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+            CardTable(std::span<const Card> cards, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+            auto push_back(const Card& card) -> void;
+            auto resize(std::size_t count) -> void;
+            auto reserve(std::size_t count) -> void;
+            auto clear() -> void;
+            auto size() const -> std::size_t;
+            auto card(std::size_t index) const -> Card;
+            auto columns() -> CardColumns;
+            auto to_cards() const -> CardVector;
+
+        private:
+            std::pmr::vector<long long> card_id;
+            std::pmr::vector<days_t> interval;
+            std::pmr::vector<double> stability;
+            std::pmr::vector<double> difficulty;
+            std::pmr::vector<State> state;
+            std::pmr::vector<int> step;
+        };
+    }
+
+    template<typename T, std::size_t N>
+    class InlineVector {
+    public:
+        constexpr InlineVector() = default;
+        constexpr InlineVector(std::initializer_list<T> values) { assign(std::span<const T>(values.begin(), values.size())); }
+
+        constexpr auto assign(std::span<const T> values) -> void {
+            if (values.size() > N) {
+                throw std::length_error("InlineVector capacity exceeded.");
+            }
+            std::ranges::copy(values, items.begin());
+            count = values.size();
+        }
+        constexpr auto push_back(const T& value) -> void {
+            if (count == N) {
+                throw std::length_error("InlineVector capacity exceeded.");
+            }
+            items[count++] = value;
+        }
+        constexpr auto clear() -> void { count = 0; }
+        constexpr auto size() const -> std::size_t { return count; }
+        constexpr auto empty() const -> bool { return count == 0; }
+        static constexpr auto capacity() -> std::size_t { return N; }
+        constexpr auto data() const -> const T* { return items.data(); }
+        constexpr auto begin() const -> const T* { return items.data(); }
+        constexpr auto end() const -> const T* { return items.data() + count; }
+        constexpr auto operator[](std::size_t i) const -> const T& { return items[i]; }
+        constexpr operator std::span<const T>() const { return { items.data(), count }; }
+        friend constexpr auto operator==(const InlineVector& a, const InlineVector& b) -> bool { return std::ranges::equal(a, b); }
+
+    private:
+        std::array<T, N> items{};
+        std::size_t count = 0;
+    };
+
+    constexpr std::size_t MAX_SCHEDULER_STEPS = 16;
+
+    struct FixedSchedulerConfig {
+        std::array<double, 21> parameters;
+        double desired_retention;
+        InlineVector<days_t, MAX_SCHEDULER_STEPS> learning_steps;
+        InlineVector<days_t, MAX_SCHEDULER_STEPS> relearning_steps;
+        int maximum_interval;
+        bool enable_fuzzing;
+        static auto from(const SchedulerConfig& cfg) -> FixedSchedulerConfig;
+        static auto from(const pmr::SchedulerConfig& cfg) -> FixedSchedulerConfig;
+        auto operator==(const FixedSchedulerConfig&) const -> bool = default;
+    };
+
+    class SplitMix64 {
+    public:
+        using result_type = std::uint64_t;
+
+        explicit constexpr SplitMix64(std::uint64_t rand_seed = 0) : state(rand_seed) {}
+        static constexpr auto min() -> result_type { return 0; }
+        static constexpr auto max() -> result_type { return std::numeric_limits<result_type>::max(); }
+        constexpr auto operator()() -> result_type {
+            return FsrsAlgorithm::mix_bits(state += 0x9E3779B97F4A7C15);
+        }
+
+    private:
+        std::uint64_t state;
+    };
+
+    class IntervalTable {
+    public:
+        // The table holds one threshold per day, so Scheduler::interval_table() rejects longer maximum intervals.
+        static constexpr int MAX_DAYS = 1 << 20;
+
+        auto operator()(double stability) const -> days_t;
+        auto lookup(std::span<const double> stability, std::span<days_t> intervals) const -> void;
+        auto minimum_stability(int interval_days) const -> double;
+        auto maximum_interval() const -> int;
+
+    private:
+        friend class Scheduler;
+        std::vector<double> thresholds;
+    };
+
     class Scheduler {
     public:
         Scheduler(const SchedulerConfig& cfg, std::mt19937& rand_gen);
+        explicit Scheduler(const SchedulerConfig& cfg, std::uint64_t rand_seed = 0);
+        Scheduler(const FixedSchedulerConfig& cfg, std::mt19937& rand_gen);
+        explicit Scheduler(const FixedSchedulerConfig& cfg, std::uint64_t rand_seed = 0);
+        explicit Scheduler(const pmr::SchedulerConfig& cfg, std::uint64_t rand_seed = 0);
         auto review_card(Card card, Rating rating, days_t review_interval) -> Card;
+        // Fuzz draws depend only on (seed, card_id, review_index), so the indexed overloads give the same
+        // result regardless of call order, batching or thread.
+        auto review_card(Card card, Rating rating, days_t review_interval, std::uint64_t review_index) const -> Card;
+        template<std::uniform_random_bit_generator Generator>
+        auto review_card(Card card, Rating rating, days_t review_interval, Generator& rand_gen) const -> Card;
+        // Single-precision memory state; intervals are still derived and fuzzed in double.
+        auto review_card(FloatCard card, Rating rating, days_t review_interval, std::uint64_t review_index) const -> FloatCard;
+        auto review_cards(CardColumns cards, std::span<const Rating> ratings, std::span<const days_t> review_intervals, BatchMode mode = BatchMode::Exact) -> void;
+        auto review_cards(CardColumns cards, std::span<const Rating> ratings, std::span<const days_t> review_intervals, std::span<const std::uint64_t> review_indices, BatchMode mode = BatchMode::Exact) const -> void;
+        // Fills the columns with new cards first_id, first_id + 1, ... reviewed once with first_ratings,
+        // the same as review_card(Card::create(id), rating, days_t(0), review_index) for each of them.
+        auto import_cards(CardColumns cards, long long first_id, std::span<const Rating> first_ratings, std::uint64_t review_index = 0) const -> void;
         auto calculate_next_review_interval(double stability) const -> days_t;
+        auto reschedule_all(std::span<const double> stability, std::span<days_t> intervals) const -> void;
+        auto interval_table() const -> IntervalTable;
+        auto get_retrievability(const Card& card, days_t elapsed) const -> double;
+        auto get_retrievability(std::span<const double> stability, std::span<const days_t> elapsed, std::span<double> retrievability, BatchMode mode = BatchMode::Exact) const -> void;
+        auto time_to_retrievability(double stability, double retrievability) const -> days_t;
 
     private:
-        auto get_long_term_stability(const Card& card, Rating rating, days_t review_interval) const -> double;
-        auto calculate_initial_reviewed_card(Card card, Rating rating, days_t review_interval) -> Card;
-        auto to_review_state(Card card) -> Card;
-        auto handle_steps(Card card, Rating rating, std::span<const days_t> steps) -> Card;
-        auto determine_next_phase_and_interval(Card reviewed_card, Rating rating) -> Card;
-        auto apply_fuzzing(Card card) -> Card;
-        auto check_and_fill_parameters(std::span<const double> p) -> std::vector<double>;
-        const SchedulerConfig& config;
-        std::mt19937& random;
-        std::vector<double> w;
-        double decay;
-        double factor;
+        auto vectorized_memory_states(CardColumns cards, std::span<const Rating> ratings, std::span<const days_t> review_intervals) const -> void;
+        auto calculate_initial_reviewed_card(State& state, int& step, double& stability, double& difficulty, Rating rating, days_t review_interval) const -> void;
+        auto determine_next_phase_and_interval(State& state, int& step, days_t& interval, double stability, Rating rating) const -> void;
+        auto review_memory_states(CardColumns cards, std::span<const Rating> ratings, std::span<const days_t> review_intervals, BatchMode mode) const -> void;
+        auto draw_random(int min_days, int max_days) -> int;
+        auto draw_counter(long long card_id, std::uint64_t review_index, int min_days, int max_days) const -> int;
+        template<typename ReviewIndex>
+        auto fuzz_intervals(CardColumns cards, ReviewIndex review_index) const -> void;
+        static auto snapshot_states(CardColumns cards) -> std::vector<State>;
+        template<std::floating_point Real>
+        static auto record_review(State previous, const BasicCard<Real>& card) -> void;
+        static auto record_reviews(std::span<const State> previous, CardColumns cards) -> void;
+        template<typename Draw>
+        auto apply_fuzzing(State state, days_t interval, Draw draw) const -> days_t;
+        FixedSchedulerConfig config;
+        std::mt19937* random;
+        std::uint64_t seed;
+        FsrsSimd::Coefficients coefficients;
+        std::array<float, 21> float_parameters;
+        std::array<Card, 4> first_reviews;
+    };
+
+    template<typename Params = DefaultSchedulerParams>
+    class StaticScheduler {
+    public:
+        static_assert(Params::parameters.size() == 21, "StaticScheduler requires all 21 parameters.");
+
+        explicit StaticScheduler(std::uint64_t rand_seed = 0);
+        auto review_card(Card card, Rating rating, days_t review_interval, std::uint64_t review_index) const -> Card;
+        auto calculate_next_review_interval(double stability) const -> days_t;
+
+    private:
+        static constexpr auto w = std::span<const double, 21>(Params::parameters);
+        std::uint64_t seed;
+        FsrsSimd::Coefficients coefficients;
     };
 }
 
 namespace FsrsAlgorithm {
     using namespace FsrsCpp;
 
-    static constexpr double MIN_DIFFICULTY = 1.0;
-    static constexpr double MAX_DIFFICULTY = 10.0;
-    static constexpr double STABILITY_MIN = 0.001;
+    export constexpr double MIN_DIFFICULTY = 1.0;
+    export constexpr double MAX_DIFFICULTY = 10.0;
+    export constexpr double STABILITY_MIN = 0.001;
 
-    static auto clamp_difficulty(double d) -> double { return std::clamp(d, MIN_DIFFICULTY, MAX_DIFFICULTY); }
-    static auto clamp_stability(double s) -> double { return std::max(s, STABILITY_MIN); }
+    export constexpr std::array<std::pair<double, double>, 21> PARAMETER_BOUNDS = { {
+        { 0.001, 100.0 }, { 0.001, 100.0 }, { 0.001, 100.0 }, { 0.001, 100.0 },
+        { 1.0, 10.0 }, { 0.001, 4.0 }, { 0.001, 4.0 }, { 0.001, 0.75 },
+        { 0.0, 4.5 }, { 0.0, 0.8 }, { 0.001, 3.5 }, { 0.001, 5.0 },
+        { 0.001, 0.25 }, { 0.001, 0.9 }, { 0.0, 4.0 }, { 0.0, 1.0 },
+        { 1.0, 6.0 }, { 0.0, 2.0 }, { 0.0, 2.0 }, { 0.0, 0.8 }, { 0.1, 0.8 }
+    } };
+
+    export auto check_and_fill_parameters(std::span<const double> p) -> std::array<double, 21> {
+        if (std::ranges::any_of(p, [](double val) { return !std::isfinite(val); })) {
+            throw std::invalid_argument("Invalid parameters: contains non-finite values.");
+        }
 
-    static auto raw_initial_difficulty(std::span<const double> w, Rating r) -> double {
-        return w[4] - std::exp(w[5] * (static_cast<double>(r) - 1.0)) + 1.0;
+        auto result = std::array<double, 21>{};
+        switch (p.size()) {
+        case 17: result[20] = 0.5; break;
+        case 19: result[20] = 0.5; break;
+        case 21: break;
+        default:
+            throw std::invalid_argument("Invalid number of parameters. Supported: 17, 19, or 21.");
+        }
+        std::ranges::copy(p, result.begin());
+        return result;
     }
 
-    static auto initial_stability(std::span<const double> w, Rating r) -> double {
+    template<typename Real>
+    using weights_t = std::span<const std::type_identity_t<Real>>;
+
+    export template<std::floating_point Real>
+    constexpr auto clamp_difficulty(Real d) -> Real { return std::clamp(d, Real(MIN_DIFFICULTY), Real(MAX_DIFFICULTY)); }
+
+    export template<std::floating_point Real>
+    constexpr auto clamp_stability(Real s) -> Real { return std::max(s, Real(STABILITY_MIN)); }
+
+    export template<std::floating_point Real = double>
+    auto raw_initial_difficulty(weights_t<Real> w, Rating r) -> Real {
+        return w[4] - std::exp(w[5] * (static_cast<Real>(r) - Real(1))) + Real(1);
+    }
+
+    export template<std::floating_point Real = double>
+    constexpr auto initial_stability(weights_t<Real> w, Rating r) -> Real {
         return clamp_stability(w[static_cast<int>(r) - 1]);
     }
 
-    static auto initial_difficulty(std::span<const double> w, Rating r) -> double {
-        return clamp_difficulty(raw_initial_difficulty(w, r));
+    export template<std::floating_point Real = double>
+    auto initial_difficulty(weights_t<Real> w, Rating r) -> Real {
+        return clamp_difficulty(raw_initial_difficulty<Real>(w, r));
+    }
+
+    auto interval_multiplier(double factor, double retention, double decay) -> double {
+        return (std::pow(retention, 1.0 / decay) - 1.0) / factor;
+    }
+
+    // days_t is a standard-layout wrapper around its count, so a column of them can be handed to the SIMD kernels as doubles.
+    static_assert(sizeof(days_t) == sizeof(double) && std::is_standard_layout_v<days_t>);
+
+    auto day_counts(std::span<const days_t> days) -> const double* {
+        return reinterpret_cast<const double*>(days.data());
     }
 
-    static auto next_interval(double factor, double retention, double decay, int max_interval, double stability) -> days_t {
-        auto interval_days = stability / factor * (std::pow(retention, 1.0 / decay) - 1.0);
+    auto day_counts(std::span<days_t> days) -> double* {
+        return reinterpret_cast<double*>(days.data());
+    }
+
+    auto next_interval(double multiplier, int max_interval, double stability) -> days_t {
+        auto interval_days = stability * multiplier;
         auto rounded_days = std::round(interval_days);
         return days_t(std::clamp(rounded_days, 1.0, static_cast<double>(max_interval)));
     }
 
-    static auto short_term_stability(std::span<const double> w, double stability, Rating rating) -> double {
-        auto r_val = static_cast<double>(rating);
-        auto increase = std::exp(w[17] * (r_val - 3.0 + w[18])) * std::pow(stability, -w[19]);
-        auto final_increase = (rating == Rating::Good || rating == Rating::Easy) ? std::max(increase, 1.0) : increase;
+    export template<std::floating_point Real>
+    auto short_term_stability(weights_t<Real> w, Real stability, Rating rating) -> Real {
+        auto r_val = static_cast<Real>(rating);
+        auto increase = std::exp(w[17] * (r_val - Real(3) + w[18])) * std::pow(stability, -w[19]);
+        auto final_increase = (rating == Rating::Good || rating == Rating::Easy) ? std::max(increase, Real(1)) : increase;
         return clamp_stability(stability * final_increase);
     }
 
-    static auto next_difficulty(std::span<const double> w, double d, Rating r) -> double {
-        auto delta = -(w[6] * (static_cast<double>(r) - 3.0));
-        auto damped = (MAX_DIFFICULTY - d) * delta / (MAX_DIFFICULTY - MIN_DIFFICULTY);
-        return clamp_difficulty(w[7] * raw_initial_difficulty(w, Rating::Easy) + (1.0 - w[7]) * (d + damped));
+    export template<std::floating_point Real>
+    auto short_term_stability(const FsrsSimd::Coefficients& c, Real stability, Rating rating) -> Real {
+        auto increase = static_cast<Real>(c.short_term_increase[static_cast<int>(rating) - 1]) * std::pow(stability, static_cast<Real>(-c.w19));
+        auto final_increase = (rating == Rating::Good || rating == Rating::Easy) ? std::max(increase, Real(1)) : increase;
+        return clamp_stability(stability * final_increase);
     }
 
-    static auto calculate_recall_stability(std::span<const double> w, double difficulty, double stability, double retrievability, Rating r) -> double {
-        auto recall_factor = std::exp(w[8]);
-        auto difficulty_weight = 11.0 - difficulty;
+    export template<std::floating_point Real>
+    auto next_difficulty(weights_t<Real> w, std::type_identity_t<Real> easy_difficulty, Real d, Rating r) -> Real {
+        auto delta = -(w[6] * (static_cast<Real>(r) - Real(3)));
+        auto damped = (Real(MAX_DIFFICULTY) - d) * delta / Real(MAX_DIFFICULTY - MIN_DIFFICULTY);
+        return clamp_difficulty(w[7] * easy_difficulty + (Real(1) - w[7]) * (d + damped));
+    }
+
+    export template<std::floating_point Real>
+    auto calculate_recall_stability(weights_t<Real> w, std::type_identity_t<Real> recall_factor, Real difficulty, Real stability, Real retrievability, Rating r) -> Real {
+        auto difficulty_weight = Real(11) - difficulty;
         auto stability_decay = std::pow(stability, -w[9]);
-        auto memory_factor = std::exp((1.0 - retrievability) * w[10]) - 1.0;
-        auto hard_penalty = (r == Rating::Hard) ? w[15] : 1.0;
-        auto easy_bonus = (r == Rating::Easy) ? w[16] : 1.0;
+        auto memory_factor = std::exp((Real(1) - retrievability) * w[10]) - Real(1);
+        auto hard_penalty = (r == Rating::Hard) ? w[15] : Real(1);
+        auto easy_bonus = (r == Rating::Easy) ? w[16] : Real(1);
         auto stability_increase = recall_factor * difficulty_weight * stability_decay * memory_factor * hard_penalty * easy_bonus;
-        return stability * (1.0 + stability_increase);
+        return stability * (Real(1) + stability_increase);
     }
 
-    static auto next_stability(std::span<const double> w, double difficulty, double stability, double retrievability, Rating r) -> double {
-        auto next = (r == Rating::Again)
-            ? w[11] * std::pow(difficulty, -w[12]) * (std::pow(stability + 1.0, w[13]) - 1.0) * std::exp((1.0 - retrievability) * w[14])
-            : calculate_recall_stability(w, difficulty, stability, retrievability, r);
-        return clamp_stability(next);
+    export template<std::floating_point Real>
+    auto retrievability(std::type_identity_t<Real> factor, std::type_identity_t<Real> decay, Real stability, days_t review_interval) -> Real {
+        auto elapsed_days = static_cast<Real>(std::max(0.0, review_interval.count()));
+        return std::pow(Real(1) + factor * elapsed_days / stability, decay);
     }
-}
 
-namespace FsrsCpp {
-
-    Card Card::create(long long id) {
-        return { id };
+    auto counter_random(std::uint64_t seed, long long card_id, std::uint64_t review_index) -> std::uint32_t {
+        auto x = mix_bits(seed + static_cast<std::uint64_t>(card_id) * 0x9E3779B97F4A7C15);
+        return static_cast<std::uint32_t>(mix_bits(x + review_index * 0xD1B54A32D192ED03) >> 32);
     }
 
-    const SchedulerConfig& SchedulerConfig::get_default() {
-        static const SchedulerConfig Default = {
-            .parameters = {0.212, 1.2931, 2.3065, 8.2956, 6.4133, 0.8334, 3.0194, 0.001, 1.8722, 0.1666, 0.796, 1.4835, 0.0614, 0.2629, 1.6483, 0.6014, 1.8729, 0.5425, 0.0912, 0.0658, 0.1542},
-            .desired_retention = 0.9,
-            .learning_steps = {minutes_t(1.0), minutes_t(10.0)},
-            .relearning_steps = {minutes_t(10.0)},
-            .maximum_interval = 36500,
-            .enable_fuzzing = true
-        };
-        return Default;
+    export template<std::floating_point Real>
+    auto next_stability(weights_t<Real> w, std::type_identity_t<Real> recall_factor, Real difficulty, Real stability, Real retrievability, Rating r) -> Real {
+        auto next = (r == Rating::Again)
+            ? w[11] * std::pow(difficulty, -w[12]) * (std::pow(stability + Real(1), w[13]) - Real(1)) * std::exp((Real(1) - retrievability) * w[14])
+            : calculate_recall_stability<Real>(w, recall_factor, difficulty, stability, retrievability, r);
+        return clamp_stability(next);
     }
 
-    Scheduler::Scheduler(const SchedulerConfig& cfg, std::mt19937& rand_gen)
-        : config(cfg),
-        random(rand_gen),
-        w(check_and_fill_parameters(config.parameters)),
-        decay(-w[20]),
-        factor(std::pow(0.9, 1.0 / decay) - 1.0) {
+    export auto scale_draw(std::uint32_t bits, int min_value, int max_value) -> int {
+        auto range = static_cast<std::uint64_t>(max_value - min_value) + 1;
+        return min_value + static_cast<int>((bits * range) >> 32);
     }
 
-    auto Scheduler::review_card(Card card, Rating rating, days_t review_interval) -> Card {
-        auto reviewed_card = calculate_initial_reviewed_card(card, rating, review_interval);
-        auto card_with_next_state = determine_next_phase_and_interval(reviewed_card, rating);
-        return apply_fuzzing(card_with_next_state);
+    export template<std::uniform_random_bit_generator Generator>
+    auto generator_draw(Generator& rand_gen, int min_value, int max_value) -> int {
+        constexpr auto span = Generator::max() - Generator::min();
+        static_assert(span == 0xFFFFFFFF || span == std::numeric_limits<std::uint64_t>::max(), "Generator must produce 32 or 64 uniform bits.");
+        auto bits = static_cast<std::uint64_t>(rand_gen() - Generator::min());
+        if constexpr (span != 0xFFFFFFFF) {
+            bits >>= 32;
+        }
+        return scale_draw(static_cast<std::uint32_t>(bits), min_value, max_value);
     }
 
-    auto Scheduler::calculate_next_review_interval(double stability) const -> days_t {
-        return FsrsAlgorithm::next_interval(factor, config.desired_retention, decay, config.maximum_interval, stability);
+    export auto counter_draw(std::uint64_t seed, long long card_id, std::uint64_t review_index, int min_value, int max_value) -> int {
+        return scale_draw(counter_random(seed, card_id, review_index), min_value, max_value);
     }
 
-    auto Scheduler::get_long_term_stability(const Card& card, Rating rating, days_t review_interval) const -> double {
-        auto elapsed_days = std::max(0.0, review_interval.count());
-        auto retrievability = std::pow(1.0 + factor * elapsed_days / card.stability, decay);
-        return FsrsAlgorithm::next_stability(w, card.difficulty, card.stability, retrievability, rating);
+    export auto precompute_coefficients(std::span<const double> w, double desired_retention) -> FsrsSimd::Coefficients {
+        auto decay = -w[20];
+        auto factor = std::pow(0.9, 1.0 / decay) - 1.0;
+        auto c = FsrsSimd::Coefficients{
+            .easy_difficulty = raw_initial_difficulty(w, Rating::Easy),
+            .recall_factor = std::exp(w[8]),
+            .decay = decay,
+            .factor = factor,
+            .interval_multiplier = interval_multiplier(factor, desired_retention, decay),
+            .w6 = w[6], .w7 = w[7], .w9 = w[9], .w10 = w[10], .w11 = w[11], .w12 = w[12], .w13 = w[13], .w14 = w[14], .w19 = w[19]
+        };
+        for (auto r : { Rating::Again, Rating::Hard, Rating::Good, Rating::Easy }) {
+            auto i = static_cast<int>(r) - 1;
+            c.initial_stability[i] = initial_stability(w, r);
+            c.initial_difficulty[i] = initial_difficulty(w, r);
+            c.short_term_increase[i] = std::exp(w[17] * (static_cast<double>(r) - 3.0 + w[18]));
+            c.recall_bonus[i] = (r == Rating::Hard) ? w[15] : (r == Rating::Easy) ? w[16] : 1.0;
+        }
+        return c;
     }
 
-    auto Scheduler::calculate_initial_reviewed_card(Card card, Rating rating, days_t review_interval) -> Card {
-        if (card.state == State::New) {
-            card.stability = FsrsAlgorithm::initial_stability(w, rating);
-            card.difficulty = FsrsAlgorithm::initial_difficulty(w, rating);
-            card.state = State::Learning;
-            card.step = 0;
-            return card;
+    template<std::floating_point Real>
+    auto next_memory_state(weights_t<Real> w, const FsrsSimd::Coefficients& c, State& state, int& step, Real& stability, Real& difficulty, Rating rating, days_t review_interval) -> void {
+        if (state == State::New) {
+            stability = static_cast<Real>(c.initial_stability[static_cast<int>(rating) - 1]);
+            difficulty = static_cast<Real>(c.initial_difficulty[static_cast<int>(rating) - 1]);
+            state = State::Learning;
+            step = 0;
+            return;
         }
 
-        auto new_difficulty = FsrsAlgorithm::next_difficulty(w, card.difficulty, rating);
+        auto new_difficulty = next_difficulty<Real>(w, static_cast<Real>(c.easy_difficulty), difficulty, rating);
         auto new_stability = (review_interval.count() < 1.0)
-            ? FsrsAlgorithm::short_term_stability(w, card.stability, rating)
-            : get_long_term_stability(card, rating, review_interval);
+            ? short_term_stability(c, stability, rating)
+            : next_stability<Real>(w, static_cast<Real>(c.recall_factor), difficulty, stability, retrievability<Real>(static_cast<Real>(c.factor), static_cast<Real>(c.decay), stability, review_interval), rating);
 
-        card.difficulty = new_difficulty;
-        card.stability = new_stability;
-        return card;
+        difficulty = new_difficulty;
+        stability = new_stability;
     }
 
-    auto Scheduler::to_review_state(Card card) -> Card {
-        card.interval = calculate_next_review_interval(card.stability);
-        card.state = State::Review;
-        card.step = 0;
-        return card;
+    auto to_review_state(State& state, int& step, days_t& interval, days_t review_interval) -> void {
+        interval = review_interval;
+        state = State::Review;
+        step = 0;
     }
 
-    auto Scheduler::handle_steps(Card card, Rating rating, std::span<const days_t> steps) -> Card {
+    auto handle_steps(State& state, int& step, days_t& interval, days_t review_interval, Rating rating, std::span<const days_t> steps) -> void {
         if (steps.empty()) {
-            return to_review_state(card);
+            return to_review_state(state, step, interval, review_interval);
         }
 
         switch (rating) {
         case Rating::Again:
-            card.state = State::Learning;
-            card.step = 0;
-            card.interval = steps[0];
+            state = State::Learning;
+            step = 0;
+            interval = steps[0];
             break;
         case Rating::Hard: {
-            card.state = State::Learning;
-            auto hard_interval = (card.step == 0 && steps.size() >= 2) ? (steps[0] + steps[1]) / 2.0
-                : (card.step == 0 && steps.size() == 1) ? steps[0] * 1.5
-                : steps[card.step];
-            card.interval = hard_interval;
+            state = State::Learning;
+            auto hard_interval = (step == 0 && steps.size() >= 2) ? (steps[0] + steps[1]) / 2.0
+                : (step == 0 && steps.size() == 1) ? steps[0] * 1.5
+                : steps[step];
+            interval = hard_interval;
             break;
         }
         case Rating::Good:
-            if (card.step + 1 >= steps.size()) {
-                return to_review_state(card);
+            if (step + 1 >= steps.size()) {
+                return to_review_state(state, step, interval, review_interval);
             }
-            card.state = State::Learning;
-            card.step++;
-            card.interval = steps[card.step];
+            state = State::Learning;
+            step++;
+            interval = steps[step];
             break;
         case Rating::Easy:
-            return to_review_state(card);
+            return to_review_state(state, step, interval, review_interval);
         }
-        return card;
     }
 
-    auto Scheduler::determine_next_phase_and_interval(Card reviewed_card, Rating rating) -> Card {
-        switch (reviewed_card.state) {
+    auto next_phase(State& state, int& step, days_t& interval, days_t review_interval, Rating rating, std::span<const days_t> learning_steps, std::span<const days_t> relearning_steps) -> void {
+        switch (state) {
         case State::Learning:
-            return handle_steps(reviewed_card, rating, config.learning_steps);
+            return handle_steps(state, step, interval, review_interval, rating, learning_steps);
         case State::Relearning:
-            return handle_steps(reviewed_card, rating, config.relearning_steps);
+            return handle_steps(state, step, interval, review_interval, rating, relearning_steps);
         case State::Review:
-            if (rating == Rating::Again && !config.relearning_steps.empty()) {
-                reviewed_card.state = State::Relearning;
-                reviewed_card.step = 0;
-                reviewed_card.interval = config.relearning_steps[0];
-                return reviewed_card;
+            if (rating == Rating::Again && !relearning_steps.empty()) {
+                state = State::Relearning;
+                step = 0;
+                interval = relearning_steps[0];
+                return;
             }
-            return to_review_state(reviewed_card);
+            return to_review_state(state, step, interval, review_interval);
         default:
-            return reviewed_card;
+            return;
         }
     }
 
-    auto Scheduler::apply_fuzzing(Card card) -> Card {
-        if (!config.enable_fuzzing || card.state != State::Review || card.interval.count() < 2.5) {
-            return card;
+    export auto fuzz_range(double interval_days) -> std::pair<int, int> {
+        auto delta = 0.15 * std::max(0.0, std::min(interval_days, 7.0) - 2.5) +
+            0.1 * std::max(0.0, std::min(interval_days, 20.0) - 7.0) +
+            0.05 * std::max(0.0, interval_days - 20.0);
+
+        return { static_cast<int>(std::round(interval_days - delta)), static_cast<int>(std::round(interval_days + delta)) };
+    }
+
+    export template<typename Draw>
+    auto fuzz_interval(days_t interval, int max_interval, Draw draw) -> days_t {
+        auto [min_days, max_days] = fuzz_range(interval.count());
+        auto fuzzed = draw(min_days, max_days);
+        auto clamped = std::clamp(fuzzed, 2, max_interval);
+        if (clamped != fuzzed) {
+            FsrsInstrumentation::record_fuzz_clamp();
         }
+        return days_t(clamped);
+    }
+}
+
+namespace FsrsCpp {
+
+    auto PackedCard::from_card(const Card& card) -> PackedCard {
+        constexpr auto id_limit = 1LL << (ID_BITS - 1);
+        if (card.card_id < -id_limit || card.card_id >= id_limit) {
+            throw std::invalid_argument("Invalid card: id does not fit in 48 bits.");
+        }
+        if (card.step < 0 || card.step > 255) {
+            throw std::invalid_argument("Invalid card: step does not fit in 8 bits.");
+        }
+
+        auto days = card.interval.count();
+        auto seconds = std::round(days * 86400.0);
+        auto interval_bits = std::uint32_t{};
+        if (!(days >= 0.0)) {
+            throw std::invalid_argument("Invalid card: interval must be non-negative.");
+        }
+        else if (days != std::floor(days) && seconds < SECONDS_FLAG) {
+            interval_bits = SECONDS_FLAG | static_cast<std::uint32_t>(seconds);
+        }
+        else if (std::round(days) < SECONDS_FLAG) {
+            interval_bits = static_cast<std::uint32_t>(std::round(days));
+        }
+        else {
+            throw std::invalid_argument("Invalid card: interval does not fit in the packed range.");
+        }
+
+        auto difficulty_bits = static_cast<std::uint64_t>(std::round(std::clamp(card.difficulty, 0.0, 10.0) * DIFFICULTY_SCALE));
+
+        auto packed = PackedCard{};
+        packed.id_difficulty = (static_cast<std::uint64_t>(card.card_id) & ((1ULL << ID_BITS) - 1)) | (difficulty_bits << ID_BITS);
+        packed.stability = static_cast<float>(card.stability);
+        packed.schedule = interval_bits | (static_cast<std::uint32_t>(card.state) << INTERVAL_BITS) | (static_cast<std::uint32_t>(card.step) << (INTERVAL_BITS + 2));
+        return packed;
+    }
+
+    auto PackedCard::to_card() const -> Card {
+        auto interval_bits = schedule & ((1u << INTERVAL_BITS) - 1);
+        auto interval = (interval_bits & SECONDS_FLAG)
+            ? days_t(std::chrono::duration<double>(interval_bits & ~SECONDS_FLAG))
+            : days_t(interval_bits);
+
+        return {
+            .card_id = static_cast<long long>(id_difficulty << (64 - ID_BITS)) >> (64 - ID_BITS),
+            .interval = interval,
+            .stability = stability,
+            .difficulty = static_cast<double>(id_difficulty >> ID_BITS) / DIFFICULTY_SCALE,
+            .state = static_cast<State>((schedule >> INTERVAL_BITS) & 0x3),
+            .step = static_cast<int>(schedule >> (INTERVAL_BITS + 2))
+        };
+    }
 
-        auto interval_days = card.interval.count();
-        auto delta_factor = [interval_days](double start, double end, double factor) {
-            return factor * std::max(0.0, std::min(interval_days, end) - start);
+    const SchedulerConfig& SchedulerConfig::get_default() {
+        using P = DefaultSchedulerParams;
+        static const SchedulerConfig Default = {
+            .parameters = {P::parameters.begin(), P::parameters.end()},
+            .desired_retention = P::desired_retention,
+            .learning_steps = {P::learning_steps.begin(), P::learning_steps.end()},
+            .relearning_steps = {P::relearning_steps.begin(), P::relearning_steps.end()},
+            .maximum_interval = P::maximum_interval,
+            .enable_fuzzing = P::enable_fuzzing
         };
+        return Default;
+    }
+
+    auto pmr::SchedulerConfig::get_default(std::pmr::memory_resource* resource) -> SchedulerConfig {
+        using P = DefaultSchedulerParams;
+        return {
+            .parameters = { P::parameters.begin(), P::parameters.end(), resource },
+            .desired_retention = P::desired_retention,
+            .learning_steps = { P::learning_steps.begin(), P::learning_steps.end(), resource },
+            .relearning_steps = { P::relearning_steps.begin(), P::relearning_steps.end(), resource },
+            .maximum_interval = P::maximum_interval,
+            .enable_fuzzing = P::enable_fuzzing
+        };
+    }
+
+    pmr::CardTable::CardTable(std::pmr::memory_resource* resource)
+        : card_id(resource),
+        interval(resource),
+        stability(resource),
+        difficulty(resource),
+        state(resource),
+        step(resource) {
+    }
 
-        auto delta = delta_factor(2.5, 7.0, 0.15) +
-            delta_factor(7.0, 20.0, 0.1) +
-            delta_factor(20.0, std::numeric_limits<double>::infinity(), 0.05);
+    pmr::CardTable::CardTable(std::span<const Card> cards, std::pmr::memory_resource* resource)
+        : CardTable(resource) {
+        reserve(cards.size());
+        for (const auto& card : cards) {
+            push_back(card);
+        }
+    }
 
-        auto min_days = static_cast<int>(std::round(interval_days - delta));
-        auto max_days = static_cast<int>(std::round(interval_days + delta));
+    auto pmr::CardTable::push_back(const Card& card) -> void {
+        card_id.push_back(card.card_id);
+        interval.push_back(card.interval);
+        stability.push_back(card.stability);
+        difficulty.push_back(card.difficulty);
+        state.push_back(card.state);
+        step.push_back(card.step);
+    }
 
+    auto pmr::CardTable::resize(std::size_t count) -> void {
+        card_id.resize(count);
+        interval.resize(count);
+        stability.resize(count);
+        difficulty.resize(count);
+        state.resize(count);
+        step.resize(count);
+    }
+
+    auto pmr::CardTable::reserve(std::size_t count) -> void {
+        card_id.reserve(count);
+        interval.reserve(count);
+        stability.reserve(count);
+        difficulty.reserve(count);
+        state.reserve(count);
+        step.reserve(count);
+    }
+
+    auto pmr::CardTable::clear() -> void {
+        resize(0);
+    }
+
+    auto pmr::CardTable::size() const -> std::size_t {
+        return card_id.size();
+    }
+
+    auto pmr::CardTable::card(std::size_t index) const -> Card {
+        return { card_id[index], interval[index], stability[index], difficulty[index], state[index], step[index] };
+    }
+
+    auto pmr::CardTable::columns() -> CardColumns {
+        return { card_id, interval, stability, difficulty, state, step };
+    }
+
+    auto pmr::CardTable::to_cards() const -> CardVector {
+        auto cards = CardVector(card_id.get_allocator());
+        cards.reserve(size());
+        for (std::size_t i = 0; i < size(); ++i) {
+            cards.push_back(card(i));
+        }
+        return cards;
+    }
+
+    template<typename Config>
+    auto fix_scheduler_config(const Config& cfg) -> FixedSchedulerConfig {
+        if (cfg.learning_steps.size() > MAX_SCHEDULER_STEPS || cfg.relearning_steps.size() > MAX_SCHEDULER_STEPS) {
+            throw std::invalid_argument("Invalid config: at most 16 learning and 16 relearning steps are supported.");
+        }
+
+        auto fixed = FixedSchedulerConfig{
+            .parameters = FsrsAlgorithm::check_and_fill_parameters(cfg.parameters),
+            .desired_retention = cfg.desired_retention,
+            .learning_steps = {},
+            .relearning_steps = {},
+            .maximum_interval = cfg.maximum_interval,
+            .enable_fuzzing = cfg.enable_fuzzing
+        };
+        fixed.learning_steps.assign(cfg.learning_steps);
+        fixed.relearning_steps.assign(cfg.relearning_steps);
+        return fixed;
+    }
+
+    auto FixedSchedulerConfig::from(const SchedulerConfig& cfg) -> FixedSchedulerConfig {
+        return fix_scheduler_config(cfg);
+    }
+
+    auto FixedSchedulerConfig::from(const pmr::SchedulerConfig& cfg) -> FixedSchedulerConfig {
+        return fix_scheduler_config(cfg);
+    }
+
+    Scheduler::Scheduler(const SchedulerConfig& cfg, std::mt19937& rand_gen)
+        : Scheduler(FixedSchedulerConfig::from(cfg), rand_gen) {
+    }
+
+    Scheduler::Scheduler(const SchedulerConfig& cfg, std::uint64_t rand_seed)
+        : Scheduler(FixedSchedulerConfig::from(cfg), rand_seed) {
+    }
+
+    Scheduler::Scheduler(const pmr::SchedulerConfig& cfg, std::uint64_t rand_seed)
+        : Scheduler(FixedSchedulerConfig::from(cfg), rand_seed) {
+    }
+
+    Scheduler::Scheduler(const FixedSchedulerConfig& cfg, std::mt19937& rand_gen)
+        : Scheduler(cfg) {
+        random = &rand_gen;
+    }
+
+    Scheduler::Scheduler(const FixedSchedulerConfig& cfg, std::uint64_t rand_seed)
+        : config(cfg),
+        random(nullptr),
+        seed(rand_seed),
+        coefficients(),
+        float_parameters(),
+        first_reviews() {
+        config.parameters = FsrsAlgorithm::check_and_fill_parameters(cfg.parameters);
+        coefficients = FsrsAlgorithm::precompute_coefficients(config.parameters, config.desired_retention);
+        std::ranges::transform(config.parameters, float_parameters.begin(), [](double p) { return static_cast<float>(p); });
+        for (auto rating : { Rating::Again, Rating::Hard, Rating::Good, Rating::Easy }) {
+            auto& card = first_reviews[static_cast<int>(rating) - 1];
+            calculate_initial_reviewed_card(card.state, card.step, card.stability, card.difficulty, rating, days_t(0.0));
+            determine_next_phase_and_interval(card.state, card.step, card.interval, card.stability, rating);
+        }
+    }
+
+    auto Scheduler::review_card(Card card, Rating rating, days_t review_interval) -> Card {
+        auto previous = card.state;
+        calculate_initial_reviewed_card(card.state, card.step, card.stability, card.difficulty, rating, review_interval);
+        determine_next_phase_and_interval(card.state, card.step, card.interval, card.stability, rating);
+        card.interval = apply_fuzzing(card.state, card.interval, [this](int min_days, int max_days) { return draw_random(min_days, max_days); });
+        record_review(previous, card);
+        return card;
+    }
+
+    auto Scheduler::review_card(Card card, Rating rating, days_t review_interval, std::uint64_t review_index) const -> Card {
+        auto previous = card.state;
+        calculate_initial_reviewed_card(card.state, card.step, card.stability, card.difficulty, rating, review_interval);
+        determine_next_phase_and_interval(card.state, card.step, card.interval, card.stability, rating);
+        card.interval = apply_fuzzing(card.state, card.interval, [&](int min_days, int max_days) { return draw_counter(card.card_id, review_index, min_days, max_days); });
+        record_review(previous, card);
+        return card;
+    }
+
+    auto Scheduler::review_card(FloatCard card, Rating rating, days_t review_interval, std::uint64_t review_index) const -> FloatCard {
+        auto previous = card.state;
+        FsrsAlgorithm::next_memory_state<float>(float_parameters, coefficients, card.state, card.step, card.stability, card.difficulty, rating, review_interval);
+        auto interval = days_t(card.interval);
+        determine_next_phase_and_interval(card.state, card.step, interval, card.stability, rating);
+        card.interval = apply_fuzzing(card.state, interval, [&](int min_days, int max_days) { return draw_counter(card.card_id, review_index, min_days, max_days); });
+        record_review(previous, card);
+        return card;
+    }
+
+    auto Scheduler::review_cards(CardColumns cards, std::span<const Rating> ratings, std::span<const days_t> review_intervals, BatchMode mode) -> void {
+        auto timer = FsrsInstrumentation::BatchTimer(cards.size());
+        auto previous = snapshot_states(cards);
+        review_memory_states(cards, ratings, review_intervals, mode);
+        for (std::size_t i = 0; i < cards.size(); ++i) {
+            determine_next_phase_and_interval(cards.state[i], cards.step[i], cards.interval[i], cards.stability[i], ratings[i]);
+        }
+        for (std::size_t i = 0; i < cards.size(); ++i) {
+            cards.interval[i] = apply_fuzzing(cards.state[i], cards.interval[i], [this](int min_days, int max_days) { return draw_random(min_days, max_days); });
+        }
+        record_reviews(previous, cards);
+    }
+
+    auto Scheduler::review_cards(CardColumns cards, std::span<const Rating> ratings, std::span<const days_t> review_intervals, std::span<const std::uint64_t> review_indices, BatchMode mode) const -> void {
+        if (review_indices.size() != cards.size()) {
+            throw std::invalid_argument("Invalid batch: all columns must have the same length.");
+        }
+
+        auto timer = FsrsInstrumentation::BatchTimer(cards.size());
+        auto previous = snapshot_states(cards);
+        review_memory_states(cards, ratings, review_intervals, mode);
+        for (std::size_t i = 0; i < cards.size(); ++i) {
+            determine_next_phase_and_interval(cards.state[i], cards.step[i], cards.interval[i], cards.stability[i], ratings[i]);
+        }
+        fuzz_intervals(cards, [&](std::size_t i) { return review_indices[i]; });
+        record_reviews(previous, cards);
+    }
+
+    auto Scheduler::import_cards(CardColumns cards, long long first_id, std::span<const Rating> first_ratings, std::uint64_t review_index) const -> void {
+        auto n = cards.size();
+        if (cards.interval.size() != n || cards.stability.size() != n || cards.difficulty.size() != n
+            || cards.state.size() != n || cards.step.size() != n || first_ratings.size() != n) {
+            throw std::invalid_argument("Invalid batch: all columns must have the same length.");
+        }
+
+        auto timer = FsrsInstrumentation::BatchTimer(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto& first = first_reviews[static_cast<int>(first_ratings[i]) - 1];
+            cards.card_id[i] = first_id + static_cast<long long>(i);
+            cards.interval[i] = first.interval;
+            cards.stability[i] = first.stability;
+            cards.difficulty[i] = first.difficulty;
+            cards.state[i] = first.state;
+            cards.step[i] = first.step;
+        }
+        fuzz_intervals(cards, [=](std::size_t) { return review_index; });
+        record_reviews(std::vector<State>(FsrsInstrumentation::enabled ? n : 0, State::New), cards);
+    }
+
+    auto Scheduler::snapshot_states(CardColumns cards) -> std::vector<State> {
+        if constexpr (FsrsInstrumentation::enabled) {
+            return { cards.state.begin(), cards.state.end() };
+        }
+        return {};
+    }
+
+    template<std::floating_point Real>
+    auto Scheduler::record_review(State previous, const BasicCard<Real>& card) -> void {
+        FsrsInstrumentation::record_review(static_cast<std::size_t>(previous), static_cast<std::size_t>(card.state), static_cast<double>(card.interval.count()));
+    }
+
+    auto Scheduler::record_reviews(std::span<const State> previous, CardColumns cards) -> void {
+        if constexpr (FsrsInstrumentation::enabled) {
+            for (std::size_t i = 0; i < previous.size(); ++i) {
+                FsrsInstrumentation::record_review(static_cast<std::size_t>(previous[i]), static_cast<std::size_t>(cards.state[i]), cards.interval[i].count());
+            }
+        }
+    }
+
+    template<typename ReviewIndex>
+    auto Scheduler::fuzz_intervals(CardColumns cards, ReviewIndex review_index) const -> void {
+        if (!config.enable_fuzzing) {
+            return;
+        }
+
+        for (std::size_t i = 0; i < cards.size(); ++i) {
+            auto interval_days = cards.interval[i].count();
+            auto [min_days, max_days] = FsrsAlgorithm::fuzz_range(interval_days);
+            auto drawn = draw_counter(cards.card_id[i], review_index(i), min_days, max_days);
+            auto fuzzed = std::clamp(drawn, 2, config.maximum_interval);
+            auto eligible = cards.state[i] == State::Review && interval_days >= 2.5;
+            if constexpr (FsrsInstrumentation::enabled) {
+                if (eligible && fuzzed != drawn) {
+                    FsrsInstrumentation::record_fuzz_clamp();
+                }
+            }
+            cards.interval[i] = days_t(eligible ? static_cast<double>(fuzzed) : interval_days);
+        }
+    }
+
+    auto Scheduler::review_memory_states(CardColumns cards, std::span<const Rating> ratings, std::span<const days_t> review_intervals, BatchMode mode) const -> void {
+        auto n = cards.size();
+        if (cards.interval.size() != n || cards.stability.size() != n || cards.difficulty.size() != n
+            || cards.state.size() != n || cards.step.size() != n || ratings.size() != n || review_intervals.size() != n) {
+            throw std::invalid_argument("Invalid batch: all columns must have the same length.");
+        }
+
+        if (mode == BatchMode::Vectorized) {
+            return vectorized_memory_states(cards, ratings, review_intervals);
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            calculate_initial_reviewed_card(cards.state[i], cards.step[i], cards.stability[i], cards.difficulty[i], ratings[i], review_intervals[i]);
+        }
+    }
+
+    auto Scheduler::vectorized_memory_states(CardColumns cards, std::span<const Rating> ratings, std::span<const days_t> review_intervals) const -> void {
+        constexpr auto chunk_size = std::size_t{ 256 };
+
+        auto rating = std::array<double, chunk_size>{};
+        auto is_new = std::array<double, chunk_size>{};
+        auto elapsed = std::array<double, chunk_size>{};
+        for (std::size_t begin = 0; begin < cards.size(); begin += chunk_size) {
+            auto count = std::min(chunk_size, cards.size() - begin);
+            for (std::size_t i = 0; i < count; ++i) {
+                rating[i] = static_cast<double>(ratings[begin + i]);
+                is_new[i] = (cards.state[begin + i] == State::New) ? 1.0 : 0.0;
+                elapsed[i] = review_intervals[begin + i].count();
+            }
+
+            FsrsSimd::memory_states(coefficients, { &cards.stability[begin], &cards.difficulty[begin], rating.data(), is_new.data(), elapsed.data() }, count);
+
+            for (std::size_t i = 0; i < count; ++i) {
+                if (is_new[i] == 1.0) {
+                    cards.state[begin + i] = State::Learning;
+                    cards.step[begin + i] = 0;
+                }
+            }
+        }
+    }
+
+    auto Scheduler::calculate_next_review_interval(double stability) const -> days_t {
+        return FsrsAlgorithm::next_interval(coefficients.interval_multiplier, config.maximum_interval, stability);
+    }
+
+    auto Scheduler::reschedule_all(std::span<const double> stability, std::span<days_t> intervals) const -> void {
+        constexpr auto chunk_size = std::size_t{ 16384 };
+
+        if (stability.size() != intervals.size()) {
+            throw std::invalid_argument("Invalid batch: all columns must have the same length.");
+        }
+
+        auto chunks = std::vector<std::size_t>((stability.size() + chunk_size - 1) / chunk_size);
+        std::iota(chunks.begin(), chunks.end(), std::size_t{});
+        // Resolved before the loop: the backend's static initialization may synchronize, which a par_unseq body must not do.
+        const auto& backend = FsrsSimd::backend();
+        std::for_each(std::execution::par_unseq, chunks.begin(), chunks.end(), [&](std::size_t chunk) {
+            auto begin = chunk * chunk_size;
+            auto count = std::min(stability.size(), begin + chunk_size) - begin;
+            backend.intervals(coefficients.interval_multiplier, static_cast<double>(config.maximum_interval), &stability[begin], FsrsAlgorithm::day_counts(intervals.subspan(begin)), count);
+        });
+    }
+
+    auto Scheduler::interval_table() const -> IntervalTable {
+        auto next_days = [this](double stability) { return calculate_next_review_interval(stability).count(); };
+        if (config.maximum_interval > IntervalTable::MAX_DAYS) {
+            throw std::invalid_argument("Invalid interval table: maximum interval must be at most IntervalTable::MAX_DAYS days.");
+        }
+        auto table = IntervalTable();
+        table.thresholds.resize(static_cast<std::size_t>(std::max(0, config.maximum_interval - 1)));
+        for (std::size_t k = 0; k < table.thresholds.size(); ++k) {
+            auto target = static_cast<double>(k + 2);
+            auto s = (target - 0.5) / coefficients.interval_multiplier;
+            while (next_days(s) >= target) {
+                s = std::nextafter(s, 0.0);
+            }
+            while (next_days(s) < target) {
+                s = std::nextafter(s, std::numeric_limits<double>::infinity());
+            }
+            table.thresholds[k] = s;
+        }
+        return table;
+    }
+
+    auto IntervalTable::operator()(double stability) const -> days_t {
+        auto above = std::upper_bound(thresholds.begin(), thresholds.end(), stability);
+        return days_t(static_cast<double>(1 + (above - thresholds.begin())));
+    }
+
+    auto IntervalTable::lookup(std::span<const double> stability, std::span<days_t> intervals) const -> void {
+        if (stability.size() != intervals.size()) {
+            throw std::invalid_argument("Invalid batch: all columns must have the same length.");
+        }
+        for (std::size_t i = 0; i < stability.size(); ++i) {
+            intervals[i] = (*this)(stability[i]);
+        }
+    }
+
+    auto IntervalTable::minimum_stability(int interval_days) const -> double {
+        if (interval_days <= 1) {
+            return 0.0;
+        }
+        return thresholds[static_cast<std::size_t>(std::min(interval_days, maximum_interval()) - 2)];
+    }
+
+    auto IntervalTable::maximum_interval() const -> int {
+        return static_cast<int>(thresholds.size()) + 1;
+    }
+
+    auto Scheduler::get_retrievability(const Card& card, days_t elapsed) const -> double {
+        if (card.state == State::New) {
+            return 0.0;
+        }
+        return FsrsAlgorithm::retrievability(coefficients.factor, coefficients.decay, card.stability, elapsed);
+    }
+
+    auto Scheduler::get_retrievability(std::span<const double> stability, std::span<const days_t> elapsed, std::span<double> retrievability, BatchMode mode) const -> void {
+        if (stability.size() != elapsed.size() || stability.size() != retrievability.size()) {
+            throw std::invalid_argument("Invalid batch: all columns must have the same length.");
+        }
+
+        if (mode == BatchMode::Vectorized) {
+            FsrsSimd::backend().retrievability(coefficients.factor, coefficients.decay, stability.data(), FsrsAlgorithm::day_counts(elapsed), retrievability.data(), stability.size());
+            return;
+        }
+
+        for (std::size_t i = 0; i < stability.size(); ++i) {
+            retrievability[i] = (stability[i] > 0.0)
+                ? FsrsAlgorithm::retrievability(coefficients.factor, coefficients.decay, stability[i], elapsed[i])
+                : 0.0;
+        }
+    }
+
+    auto Scheduler::time_to_retrievability(double stability, double retrievability) const -> days_t {
+        return days_t(stability * (std::pow(retrievability, 1.0 / coefficients.decay) - 1.0) / coefficients.factor);
+    }
+
+    auto Scheduler::calculate_initial_reviewed_card(State& state, int& step, double& stability, double& difficulty, Rating rating, days_t review_interval) const -> void {
+        FsrsAlgorithm::next_memory_state(config.parameters, coefficients, state, step, stability, difficulty, rating, review_interval);
+    }
+
+    auto Scheduler::determine_next_phase_and_interval(State& state, int& step, days_t& interval, double stability, Rating rating) const -> void {
+        FsrsAlgorithm::next_phase(state, step, interval, calculate_next_review_interval(stability), rating, config.learning_steps, config.relearning_steps);
+    }
+
+    auto Scheduler::draw_random(int min_days, int max_days) -> int {
+        if (random == nullptr) {
+            throw std::logic_error("Scheduler has no random generator: pass a review index to fuzz intervals.");
+        }
         auto dis = std::uniform_int_distribution<>(min_days, max_days);
-        auto fuzzed = dis(random);
-        card.interval = days_t(std::clamp(fuzzed, 2, config.maximum_interval));
+        return dis(*random);
+    }
+
+    auto Scheduler::draw_counter(long long card_id, std::uint64_t review_index, int min_days, int max_days) const -> int {
+        return FsrsAlgorithm::counter_draw(seed, card_id, review_index, min_days, max_days);
+    }
+
+    template<std::uniform_random_bit_generator Generator>
+    auto Scheduler::review_card(Card card, Rating rating, days_t review_interval, Generator& rand_gen) const -> Card {
+        auto previous = card.state;
+        calculate_initial_reviewed_card(card.state, card.step, card.stability, card.difficulty, rating, review_interval);
+        determine_next_phase_and_interval(card.state, card.step, card.interval, card.stability, rating);
+        card.interval = apply_fuzzing(card.state, card.interval, [&](int min_days, int max_days) { return FsrsAlgorithm::generator_draw(rand_gen, min_days, max_days); });
+        record_review(previous, card);
         return card;
     }
 
-    auto Scheduler::check_and_fill_parameters(std::span<const double> p) -> std::vector<double> {
-        if (std::ranges::any_of(p, [](double val) { return !std::isfinite(val); })) {
-            throw std::invalid_argument("Invalid parameters: contains non-finite values.");
+    template<typename Draw>
+    auto Scheduler::apply_fuzzing(State state, days_t interval, Draw draw) const -> days_t {
+        if (!config.enable_fuzzing || state != State::Review || interval.count() < 2.5) {
+            return interval;
         }
+        return FsrsAlgorithm::fuzz_interval(interval, config.maximum_interval, draw);
+    }
 
-        auto result = std::vector<double>(p.begin(), p.end());
-        switch (p.size()) {
-        case 17: result.insert(result.end(), { 0.0, 0.0, 0.0, 0.5 }); break;
-        case 19: result.insert(result.end(), { 0.0, 0.5 }); break;
-        case 21: break;
-        default:
-            throw std::invalid_argument("Invalid number of parameters. Supported: 17, 19, or 21.");
+    template<typename Params>
+    StaticScheduler<Params>::StaticScheduler(std::uint64_t rand_seed)
+        : seed(rand_seed),
+        coefficients(FsrsAlgorithm::precompute_coefficients(w, Params::desired_retention)) {
+    }
+
+    template<typename Params>
+    auto StaticScheduler<Params>::review_card(Card card, Rating rating, days_t review_interval, std::uint64_t review_index) const -> Card {
+        FsrsAlgorithm::next_memory_state(w, coefficients, card.state, card.step, card.stability, card.difficulty, rating, review_interval);
+        FsrsAlgorithm::next_phase(card.state, card.step, card.interval, calculate_next_review_interval(card.stability), rating, Params::learning_steps, Params::relearning_steps);
+        if constexpr (Params::enable_fuzzing) {
+            if (card.state == State::Review && card.interval.count() >= 2.5) {
+                card.interval = FsrsAlgorithm::fuzz_interval(card.interval, Params::maximum_interval, [&](int min_days, int max_days) {
+                    return FsrsAlgorithm::counter_draw(seed, card.card_id, review_index, min_days, max_days);
+                });
+            }
         }
-        return result;
+        return card;
+    }
+
+    template<typename Params>
+    auto StaticScheduler<Params>::calculate_next_review_interval(double stability) const -> days_t {
+        return FsrsAlgorithm::next_interval(coefficients.interval_multiplier, Params::maximum_interval, stability);
     }
 }
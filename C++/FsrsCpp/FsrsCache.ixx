@@ -0,0 +1,135 @@
+module;
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <algorithm>
+
+export module FsrsCpp.Cache;
+
+import FsrsCpp;
+
+export namespace FsrsCpp {
+
+    class SchedulerCache {
+    public:
+        explicit SchedulerCache(std::size_t capacity, std::uint64_t rand_seed = 0);
+        auto get(const SchedulerConfig& cfg) -> std::shared_ptr<const Scheduler>;
+        auto get(const FixedSchedulerConfig& cfg) -> std::shared_ptr<const Scheduler>;
+        auto size() const -> std::size_t;
+        auto capacity() const -> std::size_t;
+        static auto hash(const FixedSchedulerConfig& cfg) -> std::uint64_t;
+
+    private:
+        struct Entry {
+            FixedSchedulerConfig config;
+            std::uint64_t hash;
+            Scheduler scheduler;
+            std::atomic<std::uint64_t> last_used;
+        };
+
+        static constexpr std::size_t WAYS = 8;
+
+        auto bucket(std::uint64_t hash) const -> std::atomic<std::shared_ptr<Entry>>*;
+
+        std::size_t bucket_count;
+        std::uint64_t seed;
+        std::unique_ptr<std::atomic<std::shared_ptr<Entry>>[]> slots;
+        std::atomic<std::uint64_t> clock{ 1 };
+    };
+}
+
+namespace FsrsCaching {
+
+    static auto combine(std::uint64_t h, std::uint64_t word) -> std::uint64_t {
+        return FsrsAlgorithm::mix_bits(h ^ (word + 0x9E3779B97F4A7C15 + (h << 6) + (h >> 2)));
+    }
+}
+
+namespace FsrsCpp {
+
+    SchedulerCache::SchedulerCache(std::size_t capacity, std::uint64_t rand_seed)
+        : bucket_count(std::max<std::size_t>(1, (capacity + WAYS - 1) / WAYS)),
+        seed(rand_seed),
+        slots(std::make_unique<std::atomic<std::shared_ptr<Entry>>[]>(bucket_count * WAYS)) {
+    }
+
+    auto SchedulerCache::hash(const FixedSchedulerConfig& cfg) -> std::uint64_t {
+        auto h = std::uint64_t{ 0x46535253 };
+        for (auto p : cfg.parameters) {
+            h = FsrsCaching::combine(h, std::bit_cast<std::uint64_t>(p));
+        }
+        h = FsrsCaching::combine(h, std::bit_cast<std::uint64_t>(cfg.desired_retention));
+        for (const auto* steps : { &cfg.learning_steps, &cfg.relearning_steps }) {
+            h = FsrsCaching::combine(h, steps->size());
+            for (auto step : *steps) {
+                h = FsrsCaching::combine(h, std::bit_cast<std::uint64_t>(step.count()));
+            }
+        }
+        h = FsrsCaching::combine(h, static_cast<std::uint64_t>(cfg.maximum_interval));
+        return FsrsCaching::combine(h, cfg.enable_fuzzing ? 1 : 0);
+    }
+
+    auto SchedulerCache::bucket(std::uint64_t hash) const -> std::atomic<std::shared_ptr<Entry>>* {
+        return &slots[(hash % bucket_count) * WAYS];
+    }
+
+    auto SchedulerCache::get(const SchedulerConfig& cfg) -> std::shared_ptr<const Scheduler> {
+        return get(FixedSchedulerConfig::from(cfg));
+    }
+
+    auto SchedulerCache::get(const FixedSchedulerConfig& cfg) -> std::shared_ptr<const Scheduler> {
+        auto h = hash(cfg);
+        auto* ways = bucket(h);
+
+        for (std::size_t i = 0; i < WAYS; ++i) {
+            auto entry = ways[i].load(std::memory_order_acquire);
+            if (entry && entry->hash == h && entry->config == cfg) {
+                auto now = clock.load(std::memory_order_relaxed);
+                if (entry->last_used.load(std::memory_order_relaxed) != now) {
+                    entry->last_used.store(now, std::memory_order_relaxed);
+                }
+                return std::shared_ptr<const Scheduler>(entry, &entry->scheduler);
+            }
+        }
+
+        auto created = std::make_shared<Entry>(cfg, h, Scheduler(cfg, seed), clock.fetch_add(1, std::memory_order_relaxed) + 1);
+        for (;;) {
+            auto victim = std::size_t{};
+            auto victim_entry = ways[0].load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < WAYS; ++i) {
+                auto entry = ways[i].load(std::memory_order_acquire);
+                if (entry && entry->hash == h && entry->config == cfg) {
+                    return std::shared_ptr<const Scheduler>(entry, &entry->scheduler);
+                }
+                if (!entry) {
+                    victim = i;
+                    victim_entry = nullptr;
+                    break;
+                }
+                if (victim_entry && entry->last_used.load(std::memory_order_relaxed) < victim_entry->last_used.load(std::memory_order_relaxed)) {
+                    victim = i;
+                    victim_entry = entry;
+                }
+            }
+            if (ways[victim].compare_exchange_strong(victim_entry, created, std::memory_order_acq_rel)) {
+                return std::shared_ptr<const Scheduler>(created, &created->scheduler);
+            }
+        }
+    }
+
+    auto SchedulerCache::size() const -> std::size_t {
+        auto count = std::size_t{};
+        for (std::size_t i = 0; i < bucket_count * WAYS; ++i) {
+            if (slots[i].load(std::memory_order_relaxed)) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    auto SchedulerCache::capacity() const -> std::size_t {
+        return bucket_count * WAYS;
+    }
+}
@@ -0,0 +1,108 @@
+module;
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <set>
+#include <unordered_map>
+#include <compare>
+#include <algorithm>
+#include <utility>
+
+export module FsrsCpp.Index;
+
+import FsrsCpp;
+
+export namespace FsrsCpp {
+
+    struct AtRiskCard {
+        long long card_id{};
+        days_t crossing{};
+        double retrievability{};
+    };
+
+    class RetrievabilityIndex {
+    public:
+        RetrievabilityIndex(Scheduler scheduler, double threshold);
+        auto review_card(Card card, Rating rating, days_t now, std::uint64_t review_index) -> Card;
+        auto update(const Card& card, days_t last_review) -> void;
+        auto erase(long long card_id) -> void;
+        // Cards in the order their retrievability falls below the threshold, so every card
+        // already below it at `now` comes before any card that is still above it.
+        auto at_risk(days_t now, std::size_t count) const -> std::vector<AtRiskCard>;
+        auto size() const -> std::size_t;
+
+    private:
+        struct Key {
+            days_t crossing;
+            long long card_id;
+            auto operator<=>(const Key&) const = default;
+        };
+
+        struct Entry {
+            days_t crossing;
+            days_t last_review;
+            Card card;
+        };
+
+        Scheduler scheduler;
+        double crossing_per_stability;
+        std::set<Key> order;
+        std::unordered_map<long long, Entry> entries;
+    };
+}
+
+namespace FsrsCpp {
+
+    RetrievabilityIndex::RetrievabilityIndex(Scheduler scheduler, double threshold)
+        : scheduler(std::move(scheduler)),
+        crossing_per_stability() {
+        if (!(threshold > 0.0 && threshold < 1.0)) {
+            throw std::invalid_argument("Invalid threshold: retrievability must be in (0, 1).");
+        }
+        crossing_per_stability = this->scheduler.time_to_retrievability(1.0, threshold).count();
+    }
+
+    auto RetrievabilityIndex::review_card(Card card, Rating rating, days_t now, std::uint64_t review_index) -> Card {
+        auto it = entries.find(card.card_id);
+        auto elapsed = (it != entries.end()) ? now - it->second.last_review : days_t(0.0);
+        auto next = scheduler.review_card(card, rating, elapsed, review_index);
+        update(next, now);
+        return next;
+    }
+
+    auto RetrievabilityIndex::update(const Card& card, days_t last_review) -> void {
+        erase(card.card_id);
+        if (card.state == State::New) {
+            return;
+        }
+
+        auto crossing = last_review + days_t(card.stability * crossing_per_stability);
+        order.insert({ crossing, card.card_id });
+        entries.emplace(card.card_id, Entry{ crossing, last_review, card });
+    }
+
+    auto RetrievabilityIndex::erase(long long card_id) -> void {
+        auto it = entries.find(card_id);
+        if (it == entries.end()) {
+            return;
+        }
+        order.erase({ it->second.crossing, card_id });
+        entries.erase(it);
+    }
+
+    auto RetrievabilityIndex::at_risk(days_t now, std::size_t count) const -> std::vector<AtRiskCard> {
+        auto result = std::vector<AtRiskCard>();
+        result.reserve(std::min(count, order.size()));
+        for (auto it = order.begin(); it != order.end() && result.size() < count; ++it) {
+            const auto& entry = entries.at(it->card_id);
+            result.push_back({ it->card_id, it->crossing, scheduler.get_retrievability(entry.card, now - entry.last_review) });
+        }
+        return result;
+    }
+
+    auto RetrievabilityIndex::size() const -> std::size_t {
+        return entries.size();
+    }
+}
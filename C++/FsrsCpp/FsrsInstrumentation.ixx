@@ -0,0 +1,237 @@
+module;
+
+#ifdef FSRS_INSTRUMENTATION
+#define FSRS_INSTRUMENTATION_ENABLED true
+#else
+#define FSRS_INSTRUMENTATION_ENABLED false
+#endif
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+export module FsrsCpp:Instrumentation;
+
+export namespace FsrsInstrumentation {
+    // Compiled in with FSRS_INSTRUMENTATION; otherwise every hook is an empty inline function.
+    constexpr bool enabled = FSRS_INSTRUMENTATION_ENABLED;
+
+    constexpr std::size_t STATE_COUNT = 4;
+    constexpr std::size_t INTERVAL_BUCKETS = 18;
+
+    struct Snapshot {
+        std::array<std::array<std::uint64_t, STATE_COUNT>, STATE_COUNT> transitions{};
+        std::array<std::uint64_t, INTERVAL_BUCKETS> interval_histogram{};
+        std::uint64_t fuzz_clamps{};
+        std::uint64_t batches{};
+        std::uint64_t batch_cards{};
+        std::chrono::nanoseconds batch_time{};
+
+        auto operator+=(const Snapshot& other) -> Snapshot&;
+        auto operator-=(const Snapshot& other) -> Snapshot&;
+    };
+
+    using BatchObserver = void (*)(std::size_t cards, std::chrono::nanoseconds elapsed);
+
+    auto snapshot() -> Snapshot;
+    auto reset() -> void;
+    auto set_batch_observer(BatchObserver observer) -> void;
+    auto interval_bucket(double interval_days) -> std::size_t;
+}
+
+namespace FsrsInstrumentation {
+    auto record_review_slow(std::size_t from, std::size_t to, double interval_days) -> void;
+    auto record_fuzz_clamp_slow() -> void;
+    auto record_batch_slow(std::size_t cards, std::chrono::nanoseconds elapsed) -> void;
+}
+
+export namespace FsrsInstrumentation {
+    inline auto record_review(std::size_t from, std::size_t to, double interval_days) -> void {
+        if constexpr (enabled) {
+            record_review_slow(from, to, interval_days);
+        }
+    }
+
+    inline auto record_fuzz_clamp() -> void {
+        if constexpr (enabled) {
+            record_fuzz_clamp_slow();
+        }
+    }
+
+    class BatchTimer {
+    public:
+        explicit BatchTimer(std::size_t batch_cards) : cards(batch_cards), start() {
+            if constexpr (enabled) {
+                start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~BatchTimer() {
+            if constexpr (enabled) {
+                record_batch_slow(cards, std::chrono::steady_clock::now() - start);
+            }
+        }
+
+        BatchTimer(const BatchTimer&) = delete;
+        auto operator=(const BatchTimer&) -> BatchTimer& = delete;
+
+    private:
+        std::size_t cards;
+        std::chrono::steady_clock::time_point start;
+    };
+}
+
+namespace FsrsInstrumentation {
+    struct Accumulator {
+        std::array<std::atomic<std::uint64_t>, STATE_COUNT * STATE_COUNT> transitions{};
+        std::array<std::atomic<std::uint64_t>, INTERVAL_BUCKETS> interval_histogram{};
+        std::atomic<std::uint64_t> fuzz_clamps{};
+        std::atomic<std::uint64_t> batches{};
+        std::atomic<std::uint64_t> batch_cards{};
+        std::atomic<std::uint64_t> batch_nanoseconds{};
+
+        Accumulator();
+        ~Accumulator();
+        auto load() const -> Snapshot;
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<const Accumulator*> live;
+        Snapshot retired;
+        Snapshot baseline;
+        std::atomic<BatchObserver> observer{ nullptr };
+    };
+
+    auto registry() -> Registry& {
+        static auto instance = Registry();
+        return instance;
+    }
+
+    auto local() -> Accumulator& {
+        thread_local auto accumulator = Accumulator();
+        return accumulator;
+    }
+
+    auto bump(std::atomic<std::uint64_t>& counter, std::uint64_t amount = 1) -> void {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    Accumulator::Accumulator() {
+        auto& r = registry();
+        auto lock = std::scoped_lock(r.mutex);
+        r.live.push_back(this);
+    }
+
+    Accumulator::~Accumulator() {
+        auto& r = registry();
+        auto lock = std::scoped_lock(r.mutex);
+        r.retired += load();
+        std::erase(r.live, this);
+    }
+
+    auto Accumulator::load() const -> Snapshot {
+        auto result = Snapshot{};
+        for (std::size_t from = 0; from < STATE_COUNT; ++from) {
+            for (std::size_t to = 0; to < STATE_COUNT; ++to) {
+                result.transitions[from][to] = transitions[from * STATE_COUNT + to].load(std::memory_order_relaxed);
+            }
+        }
+        for (std::size_t i = 0; i < INTERVAL_BUCKETS; ++i) {
+            result.interval_histogram[i] = interval_histogram[i].load(std::memory_order_relaxed);
+        }
+        result.fuzz_clamps = fuzz_clamps.load(std::memory_order_relaxed);
+        result.batches = batches.load(std::memory_order_relaxed);
+        result.batch_cards = batch_cards.load(std::memory_order_relaxed);
+        result.batch_time = std::chrono::nanoseconds(batch_nanoseconds.load(std::memory_order_relaxed));
+        return result;
+    }
+
+    auto Snapshot::operator+=(const Snapshot& other) -> Snapshot& {
+        for (std::size_t from = 0; from < STATE_COUNT; ++from) {
+            for (std::size_t to = 0; to < STATE_COUNT; ++to) {
+                transitions[from][to] += other.transitions[from][to];
+            }
+        }
+        for (std::size_t i = 0; i < INTERVAL_BUCKETS; ++i) {
+            interval_histogram[i] += other.interval_histogram[i];
+        }
+        fuzz_clamps += other.fuzz_clamps;
+        batches += other.batches;
+        batch_cards += other.batch_cards;
+        batch_time += other.batch_time;
+        return *this;
+    }
+
+    auto Snapshot::operator-=(const Snapshot& other) -> Snapshot& {
+        for (std::size_t from = 0; from < STATE_COUNT; ++from) {
+            for (std::size_t to = 0; to < STATE_COUNT; ++to) {
+                transitions[from][to] -= other.transitions[from][to];
+            }
+        }
+        for (std::size_t i = 0; i < INTERVAL_BUCKETS; ++i) {
+            interval_histogram[i] -= other.interval_histogram[i];
+        }
+        fuzz_clamps -= other.fuzz_clamps;
+        batches -= other.batches;
+        batch_cards -= other.batch_cards;
+        batch_time -= other.batch_time;
+        return *this;
+    }
+
+    auto snapshot() -> Snapshot {
+        auto& r = registry();
+        auto lock = std::scoped_lock(r.mutex);
+        auto result = r.retired;
+        for (auto accumulator : r.live) {
+            result += accumulator->load();
+        }
+        result -= r.baseline;
+        return result;
+    }
+
+    auto reset() -> void {
+        auto current = snapshot();
+        auto& r = registry();
+        auto lock = std::scoped_lock(r.mutex);
+        r.baseline += current;
+    }
+
+    auto set_batch_observer(BatchObserver observer) -> void {
+        registry().observer.store(observer, std::memory_order_release);
+    }
+
+    auto interval_bucket(double interval_days) -> std::size_t {
+        if (!(interval_days >= 1.0)) {
+            return 0;
+        }
+        auto days = static_cast<std::uint64_t>(interval_days);
+        return std::min<std::size_t>(std::bit_width(days), INTERVAL_BUCKETS - 1);
+    }
+
+    auto record_review_slow(std::size_t from, std::size_t to, double interval_days) -> void {
+        auto& accumulator = local();
+        bump(accumulator.transitions[from * STATE_COUNT + to]);
+        bump(accumulator.interval_histogram[interval_bucket(interval_days)]);
+    }
+
+    auto record_fuzz_clamp_slow() -> void {
+        bump(local().fuzz_clamps);
+    }
+
+    auto record_batch_slow(std::size_t cards, std::chrono::nanoseconds elapsed) -> void {
+        auto& accumulator = local();
+        bump(accumulator.batches);
+        bump(accumulator.batch_cards, cards);
+        bump(accumulator.batch_nanoseconds, static_cast<std::uint64_t>(elapsed.count()));
+        if (auto observer = registry().observer.load(std::memory_order_acquire)) {
+            observer(cards, elapsed);
+        }
+    }
+}
@@ -0,0 +1,434 @@
+module;
+
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <span>
+#include <numeric>
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <execution>
+
+export module FsrsCpp.Optimizer;
+
+import FsrsCpp;
+
+export namespace FsrsCpp {
+
+    struct ReviewEntry {
+        Rating rating{};
+        days_t elapsed{};
+    };
+
+    using ReviewHistory = std::vector<ReviewEntry>;
+
+    struct OptimizerConfig {
+        std::vector<double> initial_parameters;
+        int epochs;
+        std::size_t batch_size;
+        double learning_rate;
+        std::uint64_t seed;
+        static const OptimizerConfig& get_default();
+    };
+
+    class Optimizer {
+    public:
+        explicit Optimizer(const OptimizerConfig& cfg);
+        auto fit(std::span<const ReviewHistory> histories) const -> std::vector<double>;
+        auto fit_users(std::span<const std::vector<ReviewHistory>> users) const -> std::vector<std::vector<double>>;
+        auto log_loss(std::span<const double> parameters, std::span<const ReviewHistory> histories) const -> double;
+        auto loss_gradient(std::span<const double> parameters, std::span<const ReviewHistory> histories) const -> std::vector<double>;
+
+    private:
+        OptimizerConfig config;
+        std::array<double, 21> initial;
+    };
+
+    struct EvaluationMetrics {
+        double log_loss = 0.0;
+        double rmse = 0.0;
+        std::size_t count = 0;
+    };
+
+    // Scores several configs against the same histories in one pass: each review is read once and
+    // applied to every config's memory state. Predicted retrievability does not depend on
+    // desired_retention, so configs differing only in retention report the same metrics.
+    class Evaluator {
+    public:
+        explicit Evaluator(std::span<const SchedulerConfig> configs);
+        auto evaluate(std::span<const ReviewHistory> histories) const -> std::vector<EvaluationMetrics>;
+        auto size() const -> std::size_t;
+
+    private:
+        std::vector<std::array<double, 21>> parameters;
+        std::vector<FsrsSimd::Coefficients> coefficients;
+    };
+}
+
+namespace FsrsTraining {
+    using namespace FsrsCpp;
+
+    constexpr std::size_t PARAMETER_COUNT = 21;
+    constexpr std::size_t CHUNK_SIZE = 64;
+    constexpr double PROBABILITY_EPSILON = 1e-4;
+
+    using Gradient = std::array<double, PARAMETER_COUNT>;
+
+    struct Totals {
+        double loss = 0.0;
+        std::size_t count = 0;
+        Gradient gradient{};
+    };
+
+    static auto add_scaled(Gradient& out, const Gradient& g, double scale) -> void {
+        for (std::size_t i = 0; i < PARAMETER_COUNT; ++i) {
+            out[i] += scale * g[i];
+        }
+    }
+
+    static auto merge(Totals& out, const Totals& other) -> void {
+        out.loss += other.loss;
+        out.count += other.count;
+        add_scaled(out.gradient, other.gradient, 1.0);
+    }
+
+    static auto clamp_parameters(std::span<double> w) -> void {
+        for (std::size_t i = 0; i < PARAMETER_COUNT; ++i) {
+            w[i] = std::clamp(w[i], FsrsAlgorithm::PARAMETER_BOUNDS[i].first, FsrsAlgorithm::PARAMETER_BOUNDS[i].second);
+        }
+    }
+
+    static auto accumulate_card(std::span<const double> w, const FsrsSimd::Coefficients& c, const ReviewHistory& history, Totals& totals) -> void {
+        if (history.empty()) {
+            return;
+        }
+
+        auto first = history.front().rating;
+        auto first_index = static_cast<int>(first) - 1;
+        auto stability = FsrsAlgorithm::initial_stability(w, first);
+        auto difficulty = FsrsAlgorithm::initial_difficulty(w, first);
+        auto d_stability = Gradient{};
+        auto d_difficulty = Gradient{};
+        if (w[first_index] > FsrsAlgorithm::STABILITY_MIN) {
+            d_stability[first_index] = 1.0;
+        }
+        auto raw_difficulty = FsrsAlgorithm::raw_initial_difficulty(w, first);
+        if (raw_difficulty > FsrsAlgorithm::MIN_DIFFICULTY && raw_difficulty < FsrsAlgorithm::MAX_DIFFICULTY) {
+            auto r_offset = static_cast<double>(first) - 1.0;
+            d_difficulty[4] = 1.0;
+            d_difficulty[5] = -r_offset * std::exp(w[5] * r_offset);
+        }
+
+        for (std::size_t i = 1; i < history.size(); ++i) {
+            auto [rating, elapsed] = history[i];
+            auto r_val = static_cast<double>(rating);
+            auto t = std::max(0.0, elapsed.count());
+
+            auto retrievability = FsrsAlgorithm::retrievability(c.factor, c.decay, stability, elapsed);
+            auto base = 1.0 + c.factor * t / stability;
+            auto d_factor_d_decay = std::pow(0.9, 1.0 / c.decay) * std::log(0.9) * (-1.0 / (c.decay * c.decay));
+            auto d_r = Gradient{};
+            add_scaled(d_r, d_stability, retrievability * c.decay * (-c.factor * t / (stability * stability)) / base);
+            d_r[20] -= retrievability * (std::log(base) + c.decay * (t / stability) * d_factor_d_decay / base);
+
+            if (t > 0.0) {
+                auto recalled = (rating == Rating::Again) ? 0.0 : 1.0;
+                auto p = std::clamp(retrievability, PROBABILITY_EPSILON, 1.0 - PROBABILITY_EPSILON);
+                totals.loss -= recalled * std::log(p) + (1.0 - recalled) * std::log(1.0 - p);
+                totals.count++;
+                if (p == retrievability) {
+                    add_scaled(totals.gradient, d_r, (1.0 - recalled) / (1.0 - p) - recalled / p);
+                }
+            }
+
+            auto new_difficulty = FsrsAlgorithm::next_difficulty(w, c.easy_difficulty, difficulty, rating);
+            auto d_new_difficulty = Gradient{};
+            auto delta = -(w[6] * (r_val - 3.0));
+            auto damped = (FsrsAlgorithm::MAX_DIFFICULTY - difficulty) * delta / (FsrsAlgorithm::MAX_DIFFICULTY - FsrsAlgorithm::MIN_DIFFICULTY);
+            auto unclamped = w[7] * c.easy_difficulty + (1.0 - w[7]) * (difficulty + damped);
+            if (unclamped > FsrsAlgorithm::MIN_DIFFICULTY && unclamped < FsrsAlgorithm::MAX_DIFFICULTY) {
+                auto range = FsrsAlgorithm::MAX_DIFFICULTY - FsrsAlgorithm::MIN_DIFFICULTY;
+                add_scaled(d_new_difficulty, d_difficulty, (1.0 - w[7]) * (1.0 - delta / range));
+                d_new_difficulty[4] += w[7];
+                d_new_difficulty[5] -= w[7] * 3.0 * std::exp(3.0 * w[5]);
+                d_new_difficulty[6] -= (1.0 - w[7]) * (FsrsAlgorithm::MAX_DIFFICULTY - difficulty) * (r_val - 3.0) / range;
+                d_new_difficulty[7] += c.easy_difficulty - (difficulty + damped);
+            }
+
+            auto new_stability = 0.0;
+            auto d_new_stability = Gradient{};
+            if (elapsed.count() < 1.0) {
+                new_stability = FsrsAlgorithm::short_term_stability(w, stability, rating);
+                auto increase = std::exp(w[17] * (r_val - 3.0 + w[18])) * std::pow(stability, -w[19]);
+                auto floored = (rating == Rating::Good || rating == Rating::Easy) && increase < 1.0;
+                if (floored) {
+                    d_new_stability = d_stability;
+                }
+                else if (stability * increase > FsrsAlgorithm::STABILITY_MIN) {
+                    add_scaled(d_new_stability, d_stability, (1.0 - w[19]) * new_stability / stability);
+                    d_new_stability[17] += new_stability * (r_val - 3.0 + w[18]);
+                    d_new_stability[18] += new_stability * w[17];
+                    d_new_stability[19] -= new_stability * std::log(stability);
+                }
+            }
+            else if (rating == Rating::Again) {
+                new_stability = FsrsAlgorithm::next_stability(w, c.recall_factor, difficulty, stability, retrievability, rating);
+                auto difficulty_term = std::pow(difficulty, -w[12]);
+                auto stability_term = std::pow(stability + 1.0, w[13]);
+                auto retrievability_term = std::exp((1.0 - retrievability) * w[14]);
+                auto forget = w[11] * difficulty_term * (stability_term - 1.0) * retrievability_term;
+                if (forget > FsrsAlgorithm::STABILITY_MIN) {
+                    add_scaled(d_new_stability, d_stability, w[11] * difficulty_term * retrievability_term * w[13] * stability_term / (stability + 1.0));
+                    add_scaled(d_new_stability, d_difficulty, -forget * w[12] / difficulty);
+                    add_scaled(d_new_stability, d_r, -forget * w[14]);
+                    d_new_stability[11] += difficulty_term * (stability_term - 1.0) * retrievability_term;
+                    d_new_stability[12] -= forget * std::log(difficulty);
+                    d_new_stability[13] += w[11] * difficulty_term * retrievability_term * stability_term * std::log(stability + 1.0);
+                    d_new_stability[14] += forget * (1.0 - retrievability);
+                }
+            }
+            else {
+                new_stability = FsrsAlgorithm::next_stability(w, c.recall_factor, difficulty, stability, retrievability, rating);
+                auto hard_penalty = (rating == Rating::Hard) ? w[15] : 1.0;
+                auto easy_bonus = (rating == Rating::Easy) ? w[16] : 1.0;
+                auto memory_growth = std::exp((1.0 - retrievability) * w[10]);
+                auto scale = c.recall_factor * (11.0 - difficulty) * std::pow(stability, -w[9]);
+                auto base_increase = scale * (memory_growth - 1.0);
+                auto increase = base_increase * hard_penalty * easy_bonus;
+                if (stability * (1.0 + increase) > FsrsAlgorithm::STABILITY_MIN) {
+                    add_scaled(d_new_stability, d_stability, 1.0 + increase * (1.0 - w[9]));
+                    add_scaled(d_new_stability, d_difficulty, -stability * increase / (11.0 - difficulty));
+                    add_scaled(d_new_stability, d_r, -stability * scale * hard_penalty * easy_bonus * w[10] * memory_growth);
+                    d_new_stability[8] += stability * increase;
+                    d_new_stability[9] -= stability * increase * std::log(stability);
+                    d_new_stability[10] += stability * scale * hard_penalty * easy_bonus * (1.0 - retrievability) * memory_growth;
+                    if (rating == Rating::Hard) {
+                        d_new_stability[15] += stability * base_increase;
+                    }
+                    if (rating == Rating::Easy) {
+                        d_new_stability[16] += stability * base_increase;
+                    }
+                }
+            }
+
+            stability = new_stability;
+            difficulty = new_difficulty;
+            d_stability = d_new_stability;
+            d_difficulty = d_new_difficulty;
+        }
+    }
+
+    static auto evaluate(std::span<const double> w, std::span<const ReviewHistory> histories, std::span<const std::size_t> order) -> Totals {
+        auto c = FsrsAlgorithm::precompute_coefficients(w, 0.9);
+        auto chunks = std::vector<Totals>((order.size() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+        auto indices = std::vector<std::size_t>(chunks.size());
+        std::iota(indices.begin(), indices.end(), std::size_t{});
+        std::for_each(std::execution::par, indices.begin(), indices.end(), [&](std::size_t chunk) {
+            auto end = std::min(order.size(), (chunk + 1) * CHUNK_SIZE);
+            for (auto i = chunk * CHUNK_SIZE; i < end; ++i) {
+                accumulate_card(w, c, histories[order[i]], chunks[chunk]);
+            }
+        });
+
+        auto totals = Totals{};
+        for (const auto& chunk : chunks) {
+            merge(totals, chunk);
+        }
+        return totals;
+    }
+
+    struct ConfigTotals {
+        double loss = 0.0;
+        double squared_error = 0.0;
+        std::size_t count = 0;
+    };
+
+    struct ConfigState {
+        double stability = 0.0;
+        double difficulty = 0.0;
+    };
+
+    static auto accumulate_configs(std::span<const std::array<double, PARAMETER_COUNT>> w, std::span<const FsrsSimd::Coefficients> c,
+        const ReviewHistory& history, std::span<ConfigState> states, std::span<ConfigTotals> totals) -> void {
+        if (history.empty()) {
+            return;
+        }
+
+        auto first = history.front().rating;
+        for (std::size_t k = 0; k < w.size(); ++k) {
+            states[k] = { FsrsAlgorithm::initial_stability(w[k], first), FsrsAlgorithm::initial_difficulty(w[k], first) };
+        }
+
+        for (std::size_t i = 1; i < history.size(); ++i) {
+            auto [rating, elapsed] = history[i];
+            auto scored = elapsed.count() > 0.0;
+            auto short_term = elapsed.count() < 1.0;
+            auto recalled = (rating == Rating::Again) ? 0.0 : 1.0;
+            for (std::size_t k = 0; k < w.size(); ++k) {
+                auto [stability, difficulty] = states[k];
+                auto retrievability = FsrsAlgorithm::retrievability(c[k].factor, c[k].decay, stability, elapsed);
+                if (scored) {
+                    auto p = std::clamp(retrievability, PROBABILITY_EPSILON, 1.0 - PROBABILITY_EPSILON);
+                    totals[k].loss -= recalled * std::log(p) + (1.0 - recalled) * std::log(1.0 - p);
+                    totals[k].squared_error += (recalled - retrievability) * (recalled - retrievability);
+                    totals[k].count++;
+                }
+                states[k].difficulty = FsrsAlgorithm::next_difficulty(w[k], c[k].easy_difficulty, difficulty, rating);
+                states[k].stability = short_term
+                    ? FsrsAlgorithm::short_term_stability(w[k], stability, rating)
+                    : FsrsAlgorithm::next_stability(w[k], c[k].recall_factor, difficulty, stability, retrievability, rating);
+            }
+        }
+    }
+
+    static auto identity_order(std::size_t count) -> std::vector<std::size_t> {
+        auto order = std::vector<std::size_t>(count);
+        std::iota(order.begin(), order.end(), std::size_t{});
+        return order;
+    }
+}
+
+namespace FsrsCpp {
+
+    const OptimizerConfig& OptimizerConfig::get_default() {
+        static const OptimizerConfig Default = {
+            .initial_parameters = SchedulerConfig::get_default().parameters,
+            .epochs = 5,
+            .batch_size = 512,
+            .learning_rate = 4e-2,
+            .seed = 0
+        };
+        return Default;
+    }
+
+    Optimizer::Optimizer(const OptimizerConfig& cfg)
+        : config(cfg),
+        initial(FsrsAlgorithm::check_and_fill_parameters(cfg.initial_parameters)) {
+        if (config.epochs < 0) {
+            throw std::invalid_argument("Invalid optimizer config: epochs must be non-negative.");
+        }
+        if (config.batch_size == 0) {
+            throw std::invalid_argument("Invalid optimizer config: batch size must be positive.");
+        }
+        if (!(config.learning_rate > 0.0)) {
+            throw std::invalid_argument("Invalid optimizer config: learning rate must be positive.");
+        }
+        FsrsTraining::clamp_parameters(initial);
+    }
+
+    auto Optimizer::fit(std::span<const ReviewHistory> histories) const -> std::vector<double> {
+        constexpr double beta1 = 0.9;
+        constexpr double beta2 = 0.999;
+        constexpr double epsilon = 1e-8;
+
+        auto w = initial;
+        auto m = FsrsTraining::Gradient{};
+        auto v = FsrsTraining::Gradient{};
+        auto beta1_power = 1.0;
+        auto beta2_power = 1.0;
+        auto order = FsrsTraining::identity_order(histories.size());
+        auto rand_gen = std::mt19937_64(config.seed);
+
+        for (auto epoch = 0; epoch < config.epochs; ++epoch) {
+            std::shuffle(order.begin(), order.end(), rand_gen);
+            for (std::size_t start = 0; start < order.size(); start += config.batch_size) {
+                auto batch = std::span<const std::size_t>(order).subspan(start, std::min(config.batch_size, order.size() - start));
+                auto totals = FsrsTraining::evaluate(w, histories, batch);
+                if (totals.count == 0) {
+                    continue;
+                }
+
+                beta1_power *= beta1;
+                beta2_power *= beta2;
+                for (std::size_t i = 0; i < FsrsTraining::PARAMETER_COUNT; ++i) {
+                    auto g = totals.gradient[i] / static_cast<double>(totals.count);
+                    m[i] = beta1 * m[i] + (1.0 - beta1) * g;
+                    v[i] = beta2 * v[i] + (1.0 - beta2) * g * g;
+                    auto m_hat = m[i] / (1.0 - beta1_power);
+                    auto v_hat = v[i] / (1.0 - beta2_power);
+                    w[i] -= config.learning_rate * m_hat / (std::sqrt(v_hat) + epsilon);
+                }
+                FsrsTraining::clamp_parameters(w);
+            }
+        }
+        return { w.begin(), w.end() };
+    }
+
+    auto Optimizer::fit_users(std::span<const std::vector<ReviewHistory>> users) const -> std::vector<std::vector<double>> {
+        auto result = std::vector<std::vector<double>>(users.size());
+        auto indices = FsrsTraining::identity_order(users.size());
+        std::for_each(std::execution::par, indices.begin(), indices.end(), [&](std::size_t user) {
+            result[user] = fit(users[user]);
+        });
+        return result;
+    }
+
+    auto Optimizer::log_loss(std::span<const double> parameters, std::span<const ReviewHistory> histories) const -> double {
+        auto w = FsrsAlgorithm::check_and_fill_parameters(parameters);
+        auto totals = FsrsTraining::evaluate(w, histories, FsrsTraining::identity_order(histories.size()));
+        return (totals.count == 0) ? 0.0 : totals.loss / static_cast<double>(totals.count);
+    }
+
+    auto Optimizer::loss_gradient(std::span<const double> parameters, std::span<const ReviewHistory> histories) const -> std::vector<double> {
+        auto w = FsrsAlgorithm::check_and_fill_parameters(parameters);
+        auto totals = FsrsTraining::evaluate(w, histories, FsrsTraining::identity_order(histories.size()));
+        auto gradient = std::vector<double>(totals.gradient.begin(), totals.gradient.end());
+        if (totals.count != 0) {
+            for (auto& g : gradient) {
+                g /= static_cast<double>(totals.count);
+            }
+        }
+        return gradient;
+    }
+
+    Evaluator::Evaluator(std::span<const SchedulerConfig> configs) {
+        if (configs.empty()) {
+            throw std::invalid_argument("Invalid evaluator: at least one config is required.");
+        }
+        parameters.reserve(configs.size());
+        coefficients.reserve(configs.size());
+        for (const auto& cfg : configs) {
+            const auto& w = parameters.emplace_back(FsrsAlgorithm::check_and_fill_parameters(cfg.parameters));
+            coefficients.push_back(FsrsAlgorithm::precompute_coefficients(w, cfg.desired_retention));
+        }
+    }
+
+    auto Evaluator::size() const -> std::size_t {
+        return parameters.size();
+    }
+
+    auto Evaluator::evaluate(std::span<const ReviewHistory> histories) const -> std::vector<EvaluationMetrics> {
+        using FsrsTraining::CHUNK_SIZE;
+        auto config_count = parameters.size();
+        auto chunk_count = (histories.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        auto chunks = std::vector<FsrsTraining::ConfigTotals>(chunk_count * config_count);
+        auto indices = FsrsTraining::identity_order(chunk_count);
+        std::for_each(std::execution::par, indices.begin(), indices.end(), [&](std::size_t chunk) {
+            auto states = std::vector<FsrsTraining::ConfigState>(config_count);
+            auto totals = std::span(chunks).subspan(chunk * config_count, config_count);
+            auto end = std::min(histories.size(), (chunk + 1) * CHUNK_SIZE);
+            for (auto i = chunk * CHUNK_SIZE; i < end; ++i) {
+                FsrsTraining::accumulate_configs(parameters, coefficients, histories[i], states, totals);
+            }
+        });
+
+        auto metrics = std::vector<EvaluationMetrics>(config_count);
+        for (std::size_t k = 0; k < config_count; ++k) {
+            auto totals = FsrsTraining::ConfigTotals{};
+            for (std::size_t chunk = 0; chunk < chunk_count; ++chunk) {
+                const auto& part = chunks[chunk * config_count + k];
+                totals.loss += part.loss;
+                totals.squared_error += part.squared_error;
+                totals.count += part.count;
+            }
+            if (totals.count != 0) {
+                auto count = static_cast<double>(totals.count);
+                metrics[k] = { totals.loss / count, std::sqrt(totals.squared_error / count), totals.count };
+            }
+        }
+        return metrics;
+    }
+}
@@ -0,0 +1,299 @@
+module;
+
+#include <vector>
+#include <chrono>
+#include <span>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <cstdint>
+
+export module FsrsCpp.Pipeline;
+
+import FsrsCpp;
+
+export namespace FsrsCpp {
+
+    struct ReviewRequest {
+        Card card{};
+        Rating rating{};
+        days_t review_interval{};
+        std::uint64_t review_index{};
+    };
+
+    struct PipelineConfig {
+        std::size_t max_batch;
+        std::chrono::microseconds linger;
+        static const PipelineConfig& get_default();
+    };
+
+    using ReviewSink = std::function<void(std::span<const Card>)>;
+
+    struct PipelineNode {
+        std::atomic<PipelineNode*> next{ nullptr };
+        ReviewRequest request{};
+        Card result{};
+        std::exception_ptr error{};
+        void (*complete)(PipelineNode&) {};
+    };
+
+    class ReviewPipeline {
+    public:
+        class Awaitable {
+        public:
+            Awaitable(ReviewPipeline& pipeline, const ReviewRequest& request);
+            auto await_ready() const noexcept -> bool { return false; }
+            auto await_suspend(std::coroutine_handle<> handle) -> void;
+            auto await_resume() -> Card;
+
+        private:
+            struct Node : PipelineNode {
+                std::coroutine_handle<> waiter;
+            };
+
+            ReviewPipeline* pipeline;
+            Node node;
+        };
+
+        ReviewPipeline(Scheduler scheduler, ReviewSink sink, const PipelineConfig& cfg = PipelineConfig::get_default());
+        ~ReviewPipeline();
+        ReviewPipeline(const ReviewPipeline&) = delete;
+        auto operator=(const ReviewPipeline&) -> ReviewPipeline& = delete;
+
+        auto submit(const ReviewRequest& request) -> std::future<Card>;
+        auto review(const ReviewRequest& request) -> Awaitable;
+        auto batches() const -> std::uint64_t;
+
+    private:
+        auto link(PipelineNode* node) -> void;
+        auto enqueue(PipelineNode* node) -> void;
+        auto dequeue() -> PipelineNode*;
+        auto collect(std::vector<PipelineNode*>& batch) -> void;
+        auto process(std::span<PipelineNode* const> batch) -> void;
+        auto run() -> void;
+
+        Scheduler scheduler;
+        ReviewSink sink;
+        PipelineConfig config;
+        PipelineNode stub;
+        std::atomic<PipelineNode*> head;
+        PipelineNode* tail;
+        std::atomic<std::uint64_t> submitted;
+        std::atomic<bool> stopping;
+        std::atomic<std::uint64_t> batch_count;
+        std::vector<long long> card_id;
+        std::vector<days_t> interval;
+        std::vector<double> stability;
+        std::vector<double> difficulty;
+        std::vector<State> state;
+        std::vector<int> step;
+        std::vector<Rating> ratings;
+        std::vector<days_t> review_intervals;
+        std::vector<std::uint64_t> review_indices;
+        std::vector<Card> results;
+        std::thread worker;
+    };
+}
+
+namespace FsrsCpp {
+
+    const PipelineConfig& PipelineConfig::get_default() {
+        static const PipelineConfig Default = {
+            .max_batch = 4096,
+            .linger = std::chrono::microseconds(500)
+        };
+        return Default;
+    }
+
+    ReviewPipeline::Awaitable::Awaitable(ReviewPipeline& pipeline, const ReviewRequest& request)
+        : pipeline(&pipeline),
+        node() {
+        node.request = request;
+        node.complete = [](PipelineNode& completed) { static_cast<Node&>(completed).waiter.resume(); };
+    }
+
+    auto ReviewPipeline::Awaitable::await_suspend(std::coroutine_handle<> handle) -> void {
+        node.waiter = handle;
+        pipeline->enqueue(&node);
+    }
+
+    auto ReviewPipeline::Awaitable::await_resume() -> Card {
+        if (node.error) {
+            std::rethrow_exception(node.error);
+        }
+        return node.result;
+    }
+
+    ReviewPipeline::ReviewPipeline(Scheduler scheduler, ReviewSink sink, const PipelineConfig& cfg)
+        : scheduler(std::move(scheduler)),
+        sink(std::move(sink)),
+        config(cfg),
+        stub(),
+        head(&stub),
+        tail(&stub),
+        submitted(0),
+        stopping(false),
+        batch_count(0) {
+        if (config.max_batch == 0) {
+            throw std::invalid_argument("Invalid pipeline config: max batch must be positive.");
+        }
+        worker = std::thread([this]() { run(); });
+    }
+
+    ReviewPipeline::~ReviewPipeline() {
+        stopping.store(true, std::memory_order_release);
+        submitted.fetch_add(1, std::memory_order_release);
+        submitted.notify_one();
+        worker.join();
+    }
+
+    auto ReviewPipeline::submit(const ReviewRequest& request) -> std::future<Card> {
+        struct Node : PipelineNode {
+            std::promise<Card> promise;
+        };
+
+        auto node = std::make_unique<Node>();
+        node->request = request;
+        node->complete = [](PipelineNode& completed) {
+            auto owned = std::unique_ptr<Node>(static_cast<Node*>(&completed));
+            if (owned->error) {
+                owned->promise.set_exception(owned->error);
+            }
+            else {
+                owned->promise.set_value(owned->result);
+            }
+        };
+        auto future = node->promise.get_future();
+        enqueue(node.release());
+        return future;
+    }
+
+    auto ReviewPipeline::review(const ReviewRequest& request) -> Awaitable {
+        return Awaitable(*this, request);
+    }
+
+    auto ReviewPipeline::batches() const -> std::uint64_t {
+        return batch_count.load(std::memory_order_relaxed);
+    }
+
+    auto ReviewPipeline::link(PipelineNode* node) -> void {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        auto previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    auto ReviewPipeline::enqueue(PipelineNode* node) -> void {
+        link(node);
+        submitted.fetch_add(1, std::memory_order_release);
+        submitted.notify_one();
+    }
+
+    auto ReviewPipeline::dequeue() -> PipelineNode* {
+        auto first = tail;
+        auto next = first->next.load(std::memory_order_acquire);
+        if (first == &stub) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            tail = next;
+            first = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            tail = next;
+            return first;
+        }
+        if (first != head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        link(&stub);
+        next = first->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            tail = next;
+            return first;
+        }
+        return nullptr;
+    }
+
+    auto ReviewPipeline::collect(std::vector<PipelineNode*>& batch) -> void {
+        while (batch.size() < config.max_batch) {
+            auto node = dequeue();
+            if (node == nullptr) {
+                return;
+            }
+            batch.push_back(node);
+        }
+    }
+
+    auto ReviewPipeline::process(std::span<PipelineNode* const> batch) -> void {
+        auto n = batch.size();
+        card_id.resize(n);
+        interval.resize(n);
+        stability.resize(n);
+        difficulty.resize(n);
+        state.resize(n);
+        step.resize(n);
+        ratings.resize(n);
+        review_intervals.resize(n);
+        review_indices.resize(n);
+        results.resize(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto& request = batch[i]->request;
+            card_id[i] = request.card.card_id;
+            interval[i] = request.card.interval;
+            stability[i] = request.card.stability;
+            difficulty[i] = request.card.difficulty;
+            state[i] = request.card.state;
+            step[i] = request.card.step;
+            ratings[i] = request.rating;
+            review_intervals[i] = request.review_interval;
+            review_indices[i] = request.review_index;
+        }
+
+        auto error = std::exception_ptr();
+        try {
+            scheduler.review_cards({ card_id, interval, stability, difficulty, state, step }, ratings, review_intervals, review_indices);
+            for (std::size_t i = 0; i < n; ++i) {
+                results[i] = Card{ card_id[i], interval[i], stability[i], difficulty[i], state[i], step[i] };
+            }
+            sink(results);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+
+        batch_count.fetch_add(1, std::memory_order_relaxed);
+        for (std::size_t i = 0; i < n; ++i) {
+            batch[i]->result = results[i];
+            batch[i]->error = error;
+            batch[i]->complete(*batch[i]);
+        }
+    }
+
+    auto ReviewPipeline::run() -> void {
+        auto batch = std::vector<PipelineNode*>();
+        batch.reserve(config.max_batch);
+        while (true) {
+            auto seen = submitted.load(std::memory_order_acquire);
+            collect(batch);
+            if (batch.empty()) {
+                if (stopping.load(std::memory_order_acquire)) {
+                    return;
+                }
+                submitted.wait(seen, std::memory_order_acquire);
+                continue;
+            }
+            if (batch.size() < config.max_batch && config.linger.count() > 0 && !stopping.load(std::memory_order_acquire)) {
+                std::this_thread::sleep_for(config.linger);
+                collect(batch);
+            }
+            process(batch);
+            batch.clear();
+        }
+    }
+}
@@ -0,0 +1,188 @@
+module;
+
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+
+export module FsrsCpp.Queue;
+
+import FsrsCpp;
+
+export namespace FsrsCpp {
+
+    class DueQueue {
+    public:
+        explicit DueQueue(days_t start = days_t(0.0));
+        auto push(const Card& card, days_t reviewed_at) -> void;
+        auto erase(long long card_id) -> void;
+        auto pop_due(days_t now) -> std::optional<long long>;
+        auto size() const -> std::size_t;
+        auto empty() const -> bool;
+
+    private:
+        struct Entry {
+            std::int64_t bucket;
+            long long card_id;
+            std::uint64_t generation;
+            auto operator>(const Entry& other) const -> bool { return bucket > other.bucket; }
+        };
+
+        class Calendar {
+        public:
+            Calendar(std::size_t bucket_count, std::int64_t start);
+            auto push(const Entry& entry) -> void;
+            auto pop(std::int64_t now) -> std::optional<Entry>;
+
+        private:
+            auto bucket(std::int64_t index) -> std::vector<Entry>&;
+            auto advance(std::int64_t now) -> void;
+
+            std::vector<std::vector<Entry>> buckets;
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<>> overflow;
+            std::int64_t cursor;
+            std::size_t head;
+            std::size_t count;
+        };
+
+        auto pop_live(Calendar& calendar, std::int64_t now) -> std::optional<long long>;
+
+        Calendar learning;
+        Calendar review;
+        std::unordered_map<long long, std::uint64_t> live;
+        std::uint64_t generation;
+    };
+}
+
+namespace FsrsQueue {
+    using namespace FsrsCpp;
+
+    constexpr std::size_t LEARNING_BUCKETS = 2048;
+    constexpr std::size_t REVIEW_BUCKETS = 1024;
+    constexpr double BUCKET_EPSILON = 1e-6;
+
+    auto minute_bucket(days_t time) -> std::int64_t {
+        return static_cast<std::int64_t>(std::floor(minutes_t(time).count() + BUCKET_EPSILON));
+    }
+
+    auto due_minute_bucket(days_t due) -> std::int64_t {
+        return static_cast<std::int64_t>(std::ceil(minutes_t(due).count() - BUCKET_EPSILON));
+    }
+
+    auto day_bucket(days_t time) -> std::int64_t {
+        return static_cast<std::int64_t>(std::floor(time.count() + BUCKET_EPSILON / 1440.0));
+    }
+}
+
+namespace FsrsCpp {
+
+    DueQueue::Calendar::Calendar(std::size_t bucket_count, std::int64_t start)
+        : buckets(bucket_count),
+        overflow(),
+        cursor(start),
+        head(0),
+        count(0) {
+    }
+
+    auto DueQueue::Calendar::bucket(std::int64_t index) -> std::vector<Entry>& {
+        auto n = static_cast<std::int64_t>(buckets.size());
+        return buckets[static_cast<std::size_t>(((index % n) + n) % n)];
+    }
+
+    auto DueQueue::Calendar::push(const Entry& entry) -> void {
+        ++count;
+        auto target = std::max(entry.bucket, cursor);
+        if (target >= cursor + static_cast<std::int64_t>(buckets.size())) {
+            overflow.push(entry);
+            return;
+        }
+        bucket(target).push_back(entry);
+    }
+
+    auto DueQueue::Calendar::advance(std::int64_t now) -> void {
+        bucket(cursor).clear();
+        head = 0;
+        ++cursor;
+        if (count == overflow.size() && !overflow.empty()) {
+            cursor = std::max(cursor, std::min(now, overflow.top().bucket - static_cast<std::int64_t>(buckets.size()) + 1));
+        }
+        auto horizon = cursor + static_cast<std::int64_t>(buckets.size());
+        while (!overflow.empty() && overflow.top().bucket < horizon) {
+            bucket(overflow.top().bucket).push_back(overflow.top());
+            overflow.pop();
+        }
+    }
+
+    auto DueQueue::Calendar::pop(std::int64_t now) -> std::optional<Entry> {
+        while (count > 0 && cursor <= now) {
+            auto& current = bucket(cursor);
+            if (head < current.size()) {
+                --count;
+                return current[head++];
+            }
+            advance(now);
+        }
+        if (count == 0 && cursor < now) {
+            bucket(cursor).clear();
+            head = 0;
+            cursor = now;
+        }
+        return std::nullopt;
+    }
+
+    DueQueue::DueQueue(days_t start)
+        : learning(FsrsQueue::LEARNING_BUCKETS, FsrsQueue::minute_bucket(start)),
+        review(FsrsQueue::REVIEW_BUCKETS, FsrsQueue::day_bucket(start)),
+        live(),
+        generation(0) {
+    }
+
+    auto DueQueue::push(const Card& card, days_t reviewed_at) -> void {
+        auto due = reviewed_at + card.interval;
+        auto entry = Entry{ 0, card.card_id, ++generation };
+        live[card.card_id] = entry.generation;
+        if (card.state == State::Learning || card.state == State::Relearning) {
+            entry.bucket = FsrsQueue::due_minute_bucket(due);
+            learning.push(entry);
+        }
+        else {
+            entry.bucket = FsrsQueue::day_bucket(due);
+            review.push(entry);
+        }
+    }
+
+    auto DueQueue::erase(long long card_id) -> void {
+        live.erase(card_id);
+    }
+
+    auto DueQueue::pop_due(days_t now) -> std::optional<long long> {
+        if (auto card_id = pop_live(learning, FsrsQueue::minute_bucket(now))) {
+            return card_id;
+        }
+        return pop_live(review, FsrsQueue::day_bucket(now));
+    }
+
+    auto DueQueue::pop_live(Calendar& calendar, std::int64_t now) -> std::optional<long long> {
+        while (auto entry = calendar.pop(now)) {
+            auto it = live.find(entry->card_id);
+            if (it != live.end() && it->second == entry->generation) {
+                live.erase(it);
+                return entry->card_id;
+            }
+        }
+        return std::nullopt;
+    }
+
+    auto DueQueue::size() const -> std::size_t {
+        return live.size();
+    }
+
+    auto DueQueue::empty() const -> bool {
+        return live.empty();
+    }
+}
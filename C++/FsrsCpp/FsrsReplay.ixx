@@ -0,0 +1,213 @@
+module;
+
+#include <vector>
+#include <chrono>
+#include <span>
+#include <numeric>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <execution>
+#include <optional>
+#include <unordered_map>
+#include <limits>
+
+export module FsrsCpp.Replay;
+
+import FsrsCpp;
+
+export namespace FsrsCpp {
+
+    using timestamp_t = std::chrono::sys_time<std::chrono::milliseconds>;
+
+    struct ReviewEvent {
+        long long card_id{};
+        timestamp_t timestamp{};
+        Rating rating{};
+    };
+
+    enum class ReplayExecution { Parallel, Sequential };
+
+    class ReplayEngine {
+    public:
+        explicit ReplayEngine(Scheduler scheduler, ReplayExecution execution = ReplayExecution::Parallel);
+        auto push(const ReviewEvent& event) -> void;
+        auto push(std::span<const ReviewEvent> events) -> void;
+        // Throws the same errors push would, without changing any card.
+        auto validate(std::span<const ReviewEvent> events) const -> void;
+        auto restore(const Card& card, timestamp_t last_review, std::uint64_t review_count) -> void;
+        auto find(long long card_id) const -> std::optional<Card>;
+        auto size() const -> std::size_t;
+        auto columns() -> CardColumns;
+        auto last_review_times() const -> std::span<const timestamp_t>;
+        auto review_counts() const -> std::span<const std::uint64_t>;
+
+    private:
+        struct Group {
+            std::size_t begin;
+            std::size_t end;
+            std::size_t slot;
+        };
+
+        auto group_events(std::span<const ReviewEvent> events) const -> void;
+        auto add_slot(long long card_id) -> std::size_t;
+        auto replay_group(std::span<const ReviewEvent> events, const Group& group) -> void;
+
+        Scheduler scheduler;
+        ReplayExecution execution;
+        std::unordered_map<long long, std::size_t> slots;
+        std::vector<long long> card_id;
+        std::vector<days_t> interval;
+        std::vector<double> stability;
+        std::vector<double> difficulty;
+        std::vector<State> state;
+        std::vector<int> step;
+        std::vector<timestamp_t> last_review;
+        std::vector<std::uint64_t> review_count;
+        mutable std::vector<std::size_t> order;
+        mutable std::vector<Group> groups;
+    };
+}
+
+namespace FsrsCpp {
+
+    ReplayEngine::ReplayEngine(Scheduler scheduler, ReplayExecution execution)
+        : scheduler(std::move(scheduler)),
+        execution(execution) {
+    }
+
+    auto ReplayEngine::push(const ReviewEvent& event) -> void {
+        push(std::span<const ReviewEvent>(&event, 1));
+    }
+
+    auto ReplayEngine::push(std::span<const ReviewEvent> events) -> void {
+        constexpr auto unassigned = std::numeric_limits<std::size_t>::max();
+
+        group_events(events);
+        for (auto& group : groups) {
+            if (group.slot == unassigned) {
+                group.slot = add_slot(events[order[group.begin]].card_id);
+            }
+        }
+
+        auto replay = [&](const Group& group) { replay_group(events, group); };
+        if (execution == ReplayExecution::Parallel) {
+            std::for_each(std::execution::par, groups.begin(), groups.end(), replay);
+        }
+        else {
+            std::for_each(groups.begin(), groups.end(), replay);
+        }
+    }
+
+    auto ReplayEngine::validate(std::span<const ReviewEvent> events) const -> void {
+        group_events(events);
+    }
+
+    auto ReplayEngine::group_events(std::span<const ReviewEvent> events) const -> void {
+        constexpr auto unassigned = std::numeric_limits<std::size_t>::max();
+
+        order.resize(events.size());
+        std::iota(order.begin(), order.end(), std::size_t{});
+        auto by_card = [&](std::size_t a, std::size_t b) { return events[a].card_id < events[b].card_id; };
+        if (execution == ReplayExecution::Parallel) {
+            std::stable_sort(std::execution::par, order.begin(), order.end(), by_card);
+        }
+        else {
+            std::stable_sort(order.begin(), order.end(), by_card);
+        }
+
+        groups.clear();
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            const auto& event = events[order[i]];
+            if (event.rating < Rating::Again || event.rating > Rating::Easy) {
+                throw std::invalid_argument("Invalid replay: rating must be Again, Hard, Good or Easy.");
+            }
+            if (i == 0 || events[order[i - 1]].card_id != event.card_id) {
+                auto found = slots.find(event.card_id);
+                if (found != slots.end() && event.timestamp < last_review[found->second]) {
+                    throw std::invalid_argument("Invalid replay: events for a card must be in timestamp order.");
+                }
+                groups.push_back({ i, i + 1, found != slots.end() ? found->second : unassigned });
+                continue;
+            }
+            if (event.timestamp < events[order[i - 1]].timestamp) {
+                throw std::invalid_argument("Invalid replay: events for a card must be in timestamp order.");
+            }
+            groups.back().end = i + 1;
+        }
+    }
+
+    auto ReplayEngine::restore(const Card& card, timestamp_t last, std::uint64_t count) -> void {
+        auto found = slots.find(card.card_id);
+        auto slot = (found != slots.end()) ? found->second : add_slot(card.card_id);
+        interval[slot] = card.interval;
+        stability[slot] = card.stability;
+        difficulty[slot] = card.difficulty;
+        state[slot] = card.state;
+        step[slot] = card.step;
+        last_review[slot] = last;
+        review_count[slot] = count;
+    }
+
+    auto ReplayEngine::add_slot(long long id) -> std::size_t {
+        auto slot = card_id.size();
+        auto card = Card::create(id);
+        slots.emplace(id, slot);
+        card_id.push_back(card.card_id);
+        interval.push_back(card.interval);
+        stability.push_back(card.stability);
+        difficulty.push_back(card.difficulty);
+        state.push_back(card.state);
+        step.push_back(card.step);
+        last_review.push_back(timestamp_t{});
+        review_count.push_back(0);
+        return slot;
+    }
+
+    auto ReplayEngine::replay_group(std::span<const ReviewEvent> events, const Group& group) -> void {
+        auto slot = group.slot;
+        auto card = Card{ card_id[slot], interval[slot], stability[slot], difficulty[slot], state[slot], step[slot] };
+        auto last = last_review[slot];
+        auto count = review_count[slot];
+
+        for (auto i = group.begin; i < group.end; ++i) {
+            const auto& event = events[order[i]];
+            auto elapsed = (count == 0) ? days_t(0.0) : std::chrono::duration_cast<days_t>(event.timestamp - last);
+            card = scheduler.review_card(card, event.rating, elapsed, count++);
+            last = event.timestamp;
+        }
+
+        interval[slot] = card.interval;
+        stability[slot] = card.stability;
+        difficulty[slot] = card.difficulty;
+        state[slot] = card.state;
+        step[slot] = card.step;
+        last_review[slot] = last;
+        review_count[slot] = count;
+    }
+
+    auto ReplayEngine::find(long long id) const -> std::optional<Card> {
+        auto found = slots.find(id);
+        if (found == slots.end()) {
+            return std::nullopt;
+        }
+        auto slot = found->second;
+        return Card{ card_id[slot], interval[slot], stability[slot], difficulty[slot], state[slot], step[slot] };
+    }
+
+    auto ReplayEngine::size() const -> std::size_t {
+        return card_id.size();
+    }
+
+    auto ReplayEngine::columns() -> CardColumns {
+        return { card_id, interval, stability, difficulty, state, step };
+    }
+
+    auto ReplayEngine::last_review_times() const -> std::span<const timestamp_t> {
+        return last_review;
+    }
+
+    auto ReplayEngine::review_counts() const -> std::span<const std::uint64_t> {
+        return review_count;
+    }
+}
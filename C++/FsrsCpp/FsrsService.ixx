@@ -0,0 +1,829 @@
+module;
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+export module FsrsCpp.Service;
+
+import FsrsCpp;
+import FsrsCpp.Replay;
+import FsrsCpp.Store;
+
+namespace FsrsShards {
+
+    struct LogRecord {
+        std::int64_t card_id;
+        std::int64_t timestamp;
+        std::int32_t rating;
+        std::uint32_t checksum;
+    };
+
+    class LogFile {
+    public:
+        LogFile() = default;
+        explicit LogFile(const std::filesystem::path& path);
+        LogFile(LogFile&& other) noexcept;
+        auto operator=(LogFile&& other) noexcept -> LogFile&;
+        LogFile(const LogFile&) = delete;
+        auto operator=(const LogFile&) -> LogFile& = delete;
+        ~LogFile();
+
+        auto write(std::span<const std::byte> bytes) -> void;
+        auto sync() -> void;
+
+    private:
+        auto close() -> void;
+
+#if defined(_WIN32)
+        HANDLE handle = nullptr;
+#else
+        int fd = -1;
+#endif
+    };
+}
+
+export namespace FsrsCpp {
+
+    struct ServiceConfig {
+        std::filesystem::path directory;
+        std::size_t shard_count;
+        std::uint64_t snapshot_interval;
+        bool sync_log;
+        bool pin_threads;
+        static const ServiceConfig& get_default();
+    };
+
+    // One partition of the service: a replay engine backed by a write-ahead log of review events and
+    // periodic snapshots in the card store format. Not thread-safe; a shard is driven by a single thread.
+    class ReviewShard {
+    public:
+        ReviewShard(const std::filesystem::path& directory, Scheduler scheduler, bool sync_log = true);
+
+        auto apply(std::span<const ReviewEvent> events) -> void;
+        auto snapshot() -> void;
+        auto find(long long card_id) const -> std::optional<Card>;
+        auto size() const -> std::size_t;
+        auto sequence() const -> std::uint64_t;
+        auto snapshot_sequence() const -> std::uint64_t;
+
+    private:
+        auto recover() -> void;
+        auto load_snapshot(std::uint64_t sequence) -> void;
+        auto open_log(std::uint64_t first_sequence) -> void;
+        auto remove_before(std::uint64_t sequence) -> void;
+
+        std::filesystem::path directory;
+        ReplayEngine engine;
+        bool sync_log;
+        FsrsShards::LogFile log;
+        std::vector<FsrsShards::LogRecord> records;
+        std::uint64_t applied;
+        std::uint64_t snapshotted;
+        bool failed;
+    };
+
+    // Partitions cards by id across shards, each owned by one worker thread, so shard state needs no locks.
+    class ShardedService {
+    public:
+        ShardedService(Scheduler scheduler, const ServiceConfig& cfg);
+        ~ShardedService();
+        ShardedService(const ShardedService&) = delete;
+        auto operator=(const ShardedService&) -> ShardedService& = delete;
+
+        auto submit(std::span<const ReviewEvent> events) -> std::future<void>;
+        auto find(long long card_id) -> std::future<std::optional<Card>>;
+        auto snapshot() -> std::future<void>;
+        auto shard_of(long long card_id) const -> std::size_t;
+        auto shard_count() const -> std::size_t;
+
+    private:
+        struct Task {
+            std::atomic<Task*> next{ nullptr };
+            std::function<void(ReviewShard&)> run;
+        };
+
+        struct Worker {
+            auto link(Task* task) -> void;
+            auto dequeue() -> Task*;
+
+            Task stub;
+            std::atomic<Task*> head{ &stub };
+            Task* tail = &stub;
+            std::atomic<std::uint64_t> submitted{ 0 };
+            std::optional<ReviewShard> shard;
+            std::thread thread;
+        };
+
+        auto enqueue(std::size_t shard, std::function<void(ReviewShard&)> run) -> void;
+        auto run(Worker& worker, std::size_t index, Scheduler scheduler, std::promise<void> ready) -> void;
+        auto stop() -> void;
+
+        ServiceConfig config;
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::atomic<bool> stopping;
+    };
+}
+
+namespace FsrsShards {
+    using namespace FsrsCpp;
+
+    static_assert(std::endian::native == std::endian::little, "The review log format is little-endian.");
+    static_assert(sizeof(LogRecord) == 24);
+
+    constexpr std::array<char, 8> LOG_MAGIC = { 'F', 'S', 'R', 'S', 'W', 'L', 'O', 'G' };
+    constexpr std::array<char, 8> SNAPSHOT_MAGIC = { 'F', 'S', 'R', 'S', 'S', 'N', 'A', 'P' };
+    constexpr std::uint32_t VERSION = 1;
+
+    struct LogHeader {
+        std::array<char, 8> magic;
+        std::uint32_t version;
+        std::uint32_t record_size;
+        std::uint64_t first_sequence;
+    };
+
+    struct SnapshotHeader {
+        std::array<char, 8> magic;
+        std::uint32_t version;
+        std::uint32_t header_size;
+        std::uint64_t sequence;
+        std::uint64_t count;
+    };
+
+    struct LogContents {
+        std::vector<ReviewEvent> events;
+        std::uintmax_t valid_size = 0;
+        bool torn = false;
+    };
+
+    auto checksum(const LogRecord& record) -> std::uint32_t {
+        auto bytes = std::array<std::byte, offsetof(LogRecord, checksum)>{};
+        std::memcpy(bytes.data(), &record, bytes.size());
+        auto hash = std::uint32_t{ 2166136261u };
+        for (auto b : bytes) {
+            hash = (hash ^ static_cast<std::uint32_t>(b)) * 16777619u;
+        }
+        return hash;
+    }
+
+    auto encode(const ReviewEvent& event) -> LogRecord {
+        auto record = LogRecord{ event.card_id, event.timestamp.time_since_epoch().count(), static_cast<std::int32_t>(event.rating), 0 };
+        record.checksum = checksum(record);
+        return record;
+    }
+
+    auto decode(const LogRecord& record) -> ReviewEvent {
+        return { record.card_id, timestamp_t(std::chrono::milliseconds(record.timestamp)), static_cast<Rating>(record.rating) };
+    }
+
+    auto sequence_name(std::string_view prefix, std::uint64_t sequence, std::string_view extension) -> std::string {
+        auto digits = std::to_string(sequence);
+        return std::string(prefix) + std::string(20 - digits.size(), '0') + digits + std::string(extension);
+    }
+
+    auto log_name(std::uint64_t first_sequence) -> std::string {
+        return sequence_name("log-", first_sequence, ".wal");
+    }
+
+    auto snapshot_name(std::uint64_t sequence, std::string_view extension) -> std::string {
+        return sequence_name("snapshot-", sequence, extension);
+    }
+
+    auto parse_sequence(std::string_view name, std::string_view prefix, std::string_view extension) -> std::optional<std::uint64_t> {
+        if (name.size() <= prefix.size() + extension.size() || !name.starts_with(prefix) || !name.ends_with(extension)) {
+            return std::nullopt;
+        }
+        auto digits = name.substr(prefix.size(), name.size() - prefix.size() - extension.size());
+        auto value = std::uint64_t{};
+        auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+        if (error != std::errc() || end != digits.data() + digits.size()) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    auto sync_path(const std::filesystem::path& path) -> void {
+#if defined(_WIN32)
+        if (std::filesystem::is_directory(path)) {
+            return;
+        }
+        auto file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        auto synced = file != INVALID_HANDLE_VALUE && FlushFileBuffers(file);
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+#else
+        auto fd = ::open(path.c_str(), O_RDONLY);
+        auto synced = fd >= 0 && ::fsync(fd) == 0;
+        if (fd >= 0) {
+            ::close(fd);
+        }
+#endif
+        if (!synced) {
+            throw std::runtime_error("Review shard: failed to sync " + path.string());
+        }
+    }
+
+    auto read_log(const std::filesystem::path& path, std::uint64_t first_sequence) -> LogContents {
+        auto file = std::ifstream(path, std::ios::binary);
+        auto bytes = std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        auto contents = LogContents{};
+        if (bytes.size() < sizeof(LogHeader)) {
+            contents.torn = !bytes.empty();
+            return contents;
+        }
+
+        auto header = LogHeader{};
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (header.magic != LOG_MAGIC || header.version != VERSION || header.record_size != sizeof(LogRecord)) {
+            throw std::invalid_argument("Invalid review log: unsupported header in " + path.string());
+        }
+        if (header.first_sequence != first_sequence) {
+            throw std::invalid_argument("Invalid review log: header does not match the file name " + path.string());
+        }
+
+        auto offset = sizeof(LogHeader);
+        for (; offset + sizeof(LogRecord) <= bytes.size(); offset += sizeof(LogRecord)) {
+            auto record = LogRecord{};
+            std::memcpy(&record, bytes.data() + offset, sizeof(record));
+            if (record.checksum != checksum(record)) {
+                break;
+            }
+            contents.events.push_back(decode(record));
+        }
+        contents.valid_size = offset;
+        contents.torn = offset != bytes.size();
+        return contents;
+    }
+
+    auto write_snapshot_meta(const std::filesystem::path& path, std::uint64_t sequence, std::span<const timestamp_t> last_review, std::span<const std::uint64_t> review_count) -> void {
+        auto header = SnapshotHeader{ SNAPSHOT_MAGIC, VERSION, sizeof(SnapshotHeader), sequence, last_review.size() };
+        auto last = std::vector<std::int64_t>(last_review.size());
+        std::ranges::transform(last_review, last.begin(), [](timestamp_t t) { return t.time_since_epoch().count(); });
+
+        auto file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(last.data()), static_cast<std::streamsize>(last.size() * sizeof(std::int64_t)));
+        file.write(reinterpret_cast<const char*>(review_count.data()), static_cast<std::streamsize>(review_count.size() * sizeof(std::uint64_t)));
+        if (!file) {
+            throw std::runtime_error("Review shard: failed to write " + path.string());
+        }
+    }
+
+    auto pin_current_thread(std::size_t index) -> void {
+        auto cores = static_cast<std::size_t>(std::max(1u, std::thread::hardware_concurrency()));
+#if defined(_WIN32)
+        SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{ 1 } << (index % std::min<std::size_t>(cores, sizeof(DWORD_PTR) * 8)));
+#elif defined(__linux__)
+        auto set = cpu_set_t{};
+        CPU_ZERO(&set);
+        CPU_SET(index % cores, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)index;
+        (void)cores;
+#endif
+    }
+
+    struct Completion {
+        explicit Completion(std::size_t parts) : remaining(parts) {}
+
+        auto finish(std::exception_ptr e) -> void {
+            if (e && !failed.exchange(true, std::memory_order_relaxed)) {
+                error = e;
+            }
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (error) {
+                    promise.set_exception(error);
+                }
+                else {
+                    promise.set_value();
+                }
+            }
+        }
+
+        std::atomic<std::size_t> remaining;
+        std::atomic<bool> failed{ false };
+        std::exception_ptr error;
+        std::promise<void> promise;
+    };
+
+    LogFile::LogFile(const std::filesystem::path& path) {
+#if defined(_WIN32)
+        handle = CreateFileW(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) {
+            handle = nullptr;
+#else
+        fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+        if (fd < 0) {
+#endif
+            throw std::runtime_error("Review log: cannot open " + path.string());
+        }
+    }
+
+    LogFile::LogFile(LogFile&& other) noexcept
+#if defined(_WIN32)
+        : handle(std::exchange(other.handle, nullptr)) {
+#else
+        : fd(std::exchange(other.fd, -1)) {
+#endif
+    }
+
+    auto LogFile::operator=(LogFile&& other) noexcept -> LogFile& {
+        if (this != &other) {
+            close();
+#if defined(_WIN32)
+            handle = std::exchange(other.handle, nullptr);
+#else
+            fd = std::exchange(other.fd, -1);
+#endif
+        }
+        return *this;
+    }
+
+    LogFile::~LogFile() {
+        close();
+    }
+
+    auto LogFile::close() -> void {
+#if defined(_WIN32)
+        if (handle != nullptr) {
+            CloseHandle(std::exchange(handle, nullptr));
+        }
+#else
+        if (fd >= 0) {
+            ::close(std::exchange(fd, -1));
+        }
+#endif
+    }
+
+    auto LogFile::write(std::span<const std::byte> bytes) -> void {
+        while (!bytes.empty()) {
+#if defined(_WIN32)
+            auto written = DWORD{};
+            if (!WriteFile(handle, bytes.data(), static_cast<DWORD>(std::min<std::size_t>(bytes.size(), 1u << 30)), &written, nullptr)) {
+                throw std::runtime_error("Review log: write failed.");
+            }
+#else
+            auto written = ::write(fd, bytes.data(), bytes.size());
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Review log: write failed.");
+            }
+#endif
+            bytes = bytes.subspan(static_cast<std::size_t>(written));
+        }
+    }
+
+    auto LogFile::sync() -> void {
+#if defined(_WIN32)
+        if (!FlushFileBuffers(handle)) {
+#else
+        if (::fsync(fd) != 0) {
+#endif
+            throw std::runtime_error("Review log: failed to sync.");
+        }
+    }
+}
+
+namespace FsrsCpp {
+
+    const ServiceConfig& ServiceConfig::get_default() {
+        static const ServiceConfig Default = {
+            .directory = {},
+            .shard_count = std::max(1u, std::thread::hardware_concurrency()),
+            .snapshot_interval = 1 << 20,
+            .sync_log = true,
+            .pin_threads = true
+        };
+        return Default;
+    }
+
+    ReviewShard::ReviewShard(const std::filesystem::path& directory, Scheduler scheduler, bool sync_log)
+        : directory(directory),
+        engine(std::move(scheduler), ReplayExecution::Sequential),
+        sync_log(sync_log),
+        log(),
+        records(),
+        applied(0),
+        snapshotted(0),
+        failed(false) {
+        recover();
+    }
+
+    auto ReviewShard::recover() -> void {
+        std::filesystem::create_directories(directory);
+        auto snapshots = std::vector<std::uint64_t>();
+        auto logs = std::vector<std::uint64_t>();
+        auto leftovers = std::vector<std::filesystem::path>();
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            auto name = entry.path().filename().string();
+            if (name.starts_with("snapshot-") && name.ends_with(".tmp")) {
+                leftovers.push_back(entry.path());
+            }
+            else if (auto sequence = FsrsShards::parse_sequence(name, "snapshot-", ".meta")) {
+                snapshots.push_back(*sequence);
+            }
+            else if (auto first = FsrsShards::parse_sequence(name, "log-", ".wal")) {
+                logs.push_back(*first);
+            }
+        }
+
+        for (const auto& path : leftovers) {
+            std::filesystem::remove(path);
+        }
+
+        if (!snapshots.empty()) {
+            load_snapshot(std::ranges::max(snapshots));
+        }
+
+        std::ranges::sort(logs);
+        auto log_end = std::optional<std::uint64_t>();
+        for (std::size_t i = 0; i < logs.size(); ++i) {
+            auto path = directory / FsrsShards::log_name(logs[i]);
+            auto contents = FsrsShards::read_log(path, logs[i]);
+            auto end = logs[i] + contents.events.size();
+            if (end > applied) {
+                if (logs[i] > applied) {
+                    throw std::runtime_error("Review shard: the log in " + directory.string() + " is missing events after the snapshot.");
+                }
+                engine.push(std::span<const ReviewEvent>(contents.events).subspan(static_cast<std::size_t>(applied - logs[i])));
+                applied = end;
+            }
+            if (contents.torn) {
+                if (i + 1 != logs.size()) {
+                    throw std::invalid_argument("Invalid review log: corrupt record before the end of the log in " + path.string());
+                }
+                std::filesystem::resize_file(path, contents.valid_size);
+            }
+            log_end = end;
+        }
+
+        open_log(log_end == applied ? logs.back() : applied);
+    }
+
+    auto ReviewShard::load_snapshot(std::uint64_t sequence) -> void {
+        auto store = CardStore::open(directory / FsrsShards::snapshot_name(sequence, ".cards"));
+        auto file = std::ifstream(directory / FsrsShards::snapshot_name(sequence, ".meta"), std::ios::binary);
+        auto header = FsrsShards::SnapshotHeader{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || header.magic != FsrsShards::SNAPSHOT_MAGIC || header.version != FsrsShards::VERSION || header.header_size != sizeof(header)) {
+            throw std::invalid_argument("Invalid snapshot: unsupported header.");
+        }
+        if (header.sequence != sequence || header.count != store.size()) {
+            throw std::invalid_argument("Invalid snapshot: metadata does not match the card store.");
+        }
+
+        auto last = std::vector<std::int64_t>(store.size());
+        auto counts = std::vector<std::uint64_t>(store.size());
+        file.read(reinterpret_cast<char*>(last.data()), static_cast<std::streamsize>(last.size() * sizeof(std::int64_t)));
+        file.read(reinterpret_cast<char*>(counts.data()), static_cast<std::streamsize>(counts.size() * sizeof(std::uint64_t)));
+        if (!file) {
+            throw std::invalid_argument("Invalid snapshot: file is truncated.");
+        }
+        for (std::size_t i = 0; i < store.size(); ++i) {
+            engine.restore(store.card(i), timestamp_t(std::chrono::milliseconds(last[i])), counts[i]);
+        }
+        applied = sequence;
+        snapshotted = sequence;
+    }
+
+    auto ReviewShard::open_log(std::uint64_t first_sequence) -> void {
+        auto path = directory / FsrsShards::log_name(first_sequence);
+        log = FsrsShards::LogFile(path);
+        if (std::filesystem::file_size(path) == 0) {
+            auto header = FsrsShards::LogHeader{ FsrsShards::LOG_MAGIC, FsrsShards::VERSION, sizeof(FsrsShards::LogRecord), first_sequence };
+            log.write(std::as_bytes(std::span(&header, 1)));
+            log.sync();
+            FsrsShards::sync_path(directory);
+        }
+    }
+
+    auto ReviewShard::apply(std::span<const ReviewEvent> events) -> void {
+        if (events.empty()) {
+            return;
+        }
+        if (failed) {
+            throw std::logic_error("Review shard: a log write failed; reopen the shard to recover from its log.");
+        }
+        engine.validate(events);
+        records.resize(events.size());
+        std::ranges::transform(events, records.begin(), FsrsShards::encode);
+        // After a failed write the log may end in a partial record, and anything appended behind it
+        // would be lost when recovery truncates there, so the shard stops accepting work.
+        try {
+            log.write(std::as_bytes(std::span(records)));
+            if (sync_log) {
+                log.sync();
+            }
+        }
+        catch (...) {
+            failed = true;
+            throw;
+        }
+        engine.push(events);
+        applied += events.size();
+    }
+
+    auto ReviewShard::snapshot() -> void {
+        if (failed) {
+            throw std::logic_error("Review shard: a log write failed; reopen the shard to recover from its log.");
+        }
+        if (applied == snapshotted) {
+            return;
+        }
+        auto cards = directory / FsrsShards::snapshot_name(applied, ".cards");
+        auto meta = directory / FsrsShards::snapshot_name(applied, ".meta");
+        auto cards_tmp = std::filesystem::path(cards) += ".tmp";
+        auto meta_tmp = std::filesystem::path(meta) += ".tmp";
+        CardStore::write(cards_tmp, engine.columns());
+        FsrsShards::write_snapshot_meta(meta_tmp, applied, engine.last_review_times(), engine.review_counts());
+        FsrsShards::sync_path(cards_tmp);
+        FsrsShards::sync_path(meta_tmp);
+        // The metadata file commits the snapshot, so it is renamed into place last.
+        std::filesystem::rename(cards_tmp, cards);
+        std::filesystem::rename(meta_tmp, meta);
+        FsrsShards::sync_path(directory);
+
+        open_log(applied);
+        snapshotted = applied;
+        remove_before(applied);
+    }
+
+    auto ReviewShard::remove_before(std::uint64_t sequence) -> void {
+        auto stale = std::vector<std::filesystem::path>();
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            auto name = entry.path().filename().string();
+            auto found = FsrsShards::parse_sequence(name, "log-", ".wal");
+            found = found ? found : FsrsShards::parse_sequence(name, "snapshot-", ".meta");
+            found = found ? found : FsrsShards::parse_sequence(name, "snapshot-", ".cards");
+            if (found && *found < sequence) {
+                stale.push_back(entry.path());
+            }
+        }
+        for (const auto& path : stale) {
+            auto error = std::error_code();
+            std::filesystem::remove(path, error);
+        }
+    }
+
+    auto ReviewShard::find(long long card_id) const -> std::optional<Card> {
+        return engine.find(card_id);
+    }
+
+    auto ReviewShard::size() const -> std::size_t {
+        return engine.size();
+    }
+
+    auto ReviewShard::sequence() const -> std::uint64_t {
+        return applied;
+    }
+
+    auto ReviewShard::snapshot_sequence() const -> std::uint64_t {
+        return snapshotted;
+    }
+
+    ShardedService::ShardedService(Scheduler scheduler, const ServiceConfig& cfg)
+        : config(cfg),
+        workers(),
+        stopping(false) {
+        if (config.directory.empty()) {
+            throw std::invalid_argument("Invalid service config: directory must be set.");
+        }
+        if (config.shard_count == 0) {
+            throw std::invalid_argument("Invalid service config: shard count must be positive.");
+        }
+        std::filesystem::create_directories(config.directory);
+        auto existing = std::size_t{};
+        for (const auto& entry : std::filesystem::directory_iterator(config.directory)) {
+            if (entry.is_directory() && FsrsShards::parse_sequence(entry.path().filename().string(), "shard-", "")) {
+                ++existing;
+            }
+        }
+        if (existing != 0 && existing != config.shard_count) {
+            throw std::invalid_argument("Invalid service config: the directory holds a different number of shards.");
+        }
+
+        auto ready = std::vector<std::promise<void>>(config.shard_count);
+        auto started = std::vector<std::future<void>>();
+        for (auto& promise : ready) {
+            started.push_back(promise.get_future());
+        }
+        for (std::size_t i = 0; i < config.shard_count; ++i) {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        for (std::size_t i = 0; i < config.shard_count; ++i) {
+            workers[i]->thread = std::thread([this, i, scheduler, promise = std::move(ready[i])]() mutable {
+                run(*workers[i], i, scheduler, std::move(promise));
+            });
+        }
+
+        auto error = std::exception_ptr();
+        for (auto& future : started) {
+            try {
+                future.get();
+            }
+            catch (...) {
+                error = error ? error : std::current_exception();
+            }
+        }
+        if (error) {
+            stop();
+            std::rethrow_exception(error);
+        }
+    }
+
+    ShardedService::~ShardedService() {
+        stop();
+    }
+
+    auto ShardedService::stop() -> void {
+        stopping.store(true, std::memory_order_release);
+        for (auto& worker : workers) {
+            worker->submitted.fetch_add(1, std::memory_order_release);
+            worker->submitted.notify_one();
+        }
+        for (auto& worker : workers) {
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+        }
+    }
+
+    auto ShardedService::run(Worker& worker, std::size_t index, Scheduler scheduler, std::promise<void> ready) -> void {
+        if (config.pin_threads) {
+            FsrsShards::pin_current_thread(index);
+        }
+        try {
+            worker.shard.emplace(config.directory / ("shard-" + std::to_string(index)), std::move(scheduler), config.sync_log);
+            ready.set_value();
+        }
+        catch (...) {
+            ready.set_exception(std::current_exception());
+            return;
+        }
+
+        while (true) {
+            auto seen = worker.submitted.load(std::memory_order_acquire);
+            if (auto task = std::unique_ptr<Task>(worker.dequeue())) {
+                task->run(*worker.shard);
+                continue;
+            }
+            if (stopping.load(std::memory_order_acquire)) {
+                break;
+            }
+            worker.submitted.wait(seen, std::memory_order_acquire);
+        }
+
+        // Every applied event is already in the log, so a failed final snapshot only makes the next recovery longer.
+        try {
+            worker.shard->snapshot();
+        }
+        catch (...) {
+        }
+    }
+
+    auto ShardedService::Worker::link(Task* task) -> void {
+        task->next.store(nullptr, std::memory_order_relaxed);
+        auto previous = head.exchange(task, std::memory_order_acq_rel);
+        previous->next.store(task, std::memory_order_release);
+    }
+
+    auto ShardedService::Worker::dequeue() -> Task* {
+        auto first = tail;
+        auto next = first->next.load(std::memory_order_acquire);
+        if (first == &stub) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            tail = next;
+            first = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            tail = next;
+            return first;
+        }
+        if (first != head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        link(&stub);
+        next = first->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            tail = next;
+            return first;
+        }
+        return nullptr;
+    }
+
+    auto ShardedService::enqueue(std::size_t shard, std::function<void(ReviewShard&)> run) -> void {
+        auto task = std::make_unique<Task>();
+        task->run = std::move(run);
+        auto& worker = *workers[shard];
+        worker.link(task.release());
+        worker.submitted.fetch_add(1, std::memory_order_release);
+        worker.submitted.notify_one();
+    }
+
+    auto ShardedService::submit(std::span<const ReviewEvent> events) -> std::future<void> {
+        auto parts = std::vector<std::vector<ReviewEvent>>(workers.size());
+        for (const auto& event : events) {
+            parts[shard_of(event.card_id)].push_back(event);
+        }
+        auto used = static_cast<std::size_t>(std::ranges::count_if(parts, [](const auto& part) { return !part.empty(); }));
+        auto completion = std::make_shared<FsrsShards::Completion>(used);
+        auto future = completion->promise.get_future();
+        if (used == 0) {
+            completion->promise.set_value();
+            return future;
+        }
+
+        auto interval = config.snapshot_interval;
+        for (std::size_t i = 0; i < parts.size(); ++i) {
+            if (parts[i].empty()) {
+                continue;
+            }
+            enqueue(i, [part = std::move(parts[i]), completion, interval](ReviewShard& shard) {
+                auto error = std::exception_ptr();
+                try {
+                    shard.apply(part);
+                    if (interval != 0 && shard.sequence() - shard.snapshot_sequence() >= interval) {
+                        shard.snapshot();
+                    }
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+                completion->finish(error);
+            });
+        }
+        return future;
+    }
+
+    auto ShardedService::find(long long card_id) -> std::future<std::optional<Card>> {
+        auto promise = std::make_shared<std::promise<std::optional<Card>>>();
+        auto future = promise->get_future();
+        enqueue(shard_of(card_id), [promise, card_id](ReviewShard& shard) { promise->set_value(shard.find(card_id)); });
+        return future;
+    }
+
+    auto ShardedService::snapshot() -> std::future<void> {
+        auto completion = std::make_shared<FsrsShards::Completion>(workers.size());
+        auto future = completion->promise.get_future();
+        for (std::size_t i = 0; i < workers.size(); ++i) {
+            enqueue(i, [completion](ReviewShard& shard) {
+                auto error = std::exception_ptr();
+                try {
+                    shard.snapshot();
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+                completion->finish(error);
+            });
+        }
+        return future;
+    }
+
+    auto ShardedService::shard_of(long long card_id) const -> std::size_t {
+        return static_cast<std::size_t>(static_cast<std::uint64_t>(card_id) % workers.size());
+    }
+
+    auto ShardedService::shard_count() const -> std::size_t {
+        return workers.size();
+    }
+}
@@ -0,0 +1,472 @@
+module;
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FSRS_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define FSRS_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC and Clang only accept intrinsics inside functions compiled for their instruction set; the kernel
+// entry points also flatten so the shared lane templates are inlined into the target-specific code.
+// MSVC accepts every intrinsic regardless of /arch, so the x86 backends need no annotation there.
+#if defined(FSRS_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define FSRS_LANES(isa) __attribute__((target(isa)))
+#define FSRS_KERNEL(isa) __attribute__((target(isa), flatten))
+#else
+#define FSRS_LANES(isa)
+#define FSRS_KERNEL(isa)
+#endif
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <numbers>
+#include <span>
+#include <vector>
+
+export module FsrsCpp:Simd;
+
+#if defined(FSRS_SIMD_X86) && defined(__GNUC__) && !defined(__clang__)
+// The lane templates are only instantiated inside the flattened kernels, so no vector crosses a call boundary.
+// This follows the module declaration because the global module fragment may only hold #includes.
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+export namespace FsrsSimd {
+    // Branch-free approximations used by BatchMode::Vectorized, measured against std::exp/std::log/std::pow:
+    // fast_exp <= 1 ulp on [-708, 709], fast_log <= 1 ulp on positive normals,
+    // fast_pow <= 3 + |y * ln(x)| ulp (the log error is amplified by the exponent).
+    // Every backend runs the same sequence of operations, so unless the compiler contracts them into FMA
+    // (MSVC does not by default) the results do not depend on the instruction set.
+    auto fast_exp(double x) -> double;
+    auto fast_log(double x) -> double;
+    auto fast_pow(double x, double y) -> double;
+
+    struct Coefficients {
+        std::array<double, 4> initial_stability;
+        std::array<double, 4> initial_difficulty;
+        std::array<double, 4> short_term_increase;
+        std::array<double, 4> recall_bonus;
+        double easy_difficulty;
+        double recall_factor;
+        double decay;
+        double factor;
+        double interval_multiplier;
+        double w6, w7, w9, w10, w11, w12, w13, w14, w19;
+    };
+
+    struct MemoryStateLanes {
+        double* stability;
+        double* difficulty;
+        const double* rating;
+        const double* is_new;
+        const double* elapsed;
+    };
+
+    // One table of kernels per instruction set. The intervals kernel is exact on every backend;
+    // memory_states and retrievability use the fast_* approximations above.
+    struct Backend {
+        const char* name;
+        std::size_t width;
+        void (*memory_states)(const Coefficients& c, MemoryStateLanes lanes, std::size_t count);
+        void (*retrievability)(double factor, double decay, const double* stability, const double* elapsed, double* retrievability, std::size_t count);
+        void (*intervals)(double multiplier, double max_interval, const double* stability, double* intervals, std::size_t count);
+    };
+
+    // Backends the running CPU supports, widest last; the widest is selected on first use.
+    auto supported_backends() -> std::span<const Backend>;
+    auto backend() -> const Backend&;
+    auto backend_name() -> const char*;
+}
+
+namespace FsrsSimd {
+
+    struct ScalarLanes {
+        using vec = double;
+        using ivec = std::int64_t;
+        static constexpr std::size_t width = 1;
+        static constexpr const char* name = "scalar";
+
+        static auto load(const double* p) -> vec { return *p; }
+        static auto store(double* p, vec v) -> void { *p = v; }
+        static auto set(double v) -> vec { return v; }
+        static auto add(vec a, vec b) -> vec { return a + b; }
+        static auto sub(vec a, vec b) -> vec { return a - b; }
+        static auto mul(vec a, vec b) -> vec { return a * b; }
+        static auto div(vec a, vec b) -> vec { return a / b; }
+        static auto min(vec a, vec b) -> vec { return b < a ? b : a; }
+        static auto max(vec a, vec b) -> vec { return a < b ? b : a; }
+        static auto trunc(vec a) -> vec { return std::trunc(a); }
+        static auto less(vec a, vec b) -> bool { return a < b; }
+        static auto equal(vec a, vec b) -> bool { return a == b; }
+        static auto select(bool m, vec a, vec b) -> vec { return m ? a : b; }
+        static auto to_bits(vec v) -> ivec { return std::bit_cast<ivec>(v); }
+        static auto from_bits(ivec v) -> vec { return std::bit_cast<vec>(v); }
+        static auto iset(std::int64_t v) -> ivec { return v; }
+        static auto iadd(ivec a, ivec b) -> ivec { return a + b; }
+        static auto isub(ivec a, ivec b) -> ivec { return a - b; }
+        static auto iand(ivec a, ivec b) -> ivec { return a & b; }
+        static auto ior(ivec a, ivec b) -> ivec { return a | b; }
+        template<int N> static auto ishl(ivec a) -> ivec { return a << N; }
+        template<int N> static auto ishr(ivec a) -> ivec { return static_cast<ivec>(static_cast<std::uint64_t>(a) >> N); }
+    };
+
+#if defined(FSRS_SIMD_X86)
+    struct Avx512Lanes {
+        using vec = __m512d;
+        using ivec = __m512i;
+        static constexpr std::size_t width = 8;
+        static constexpr const char* name = "avx512";
+
+        FSRS_LANES("avx512f") static auto load(const double* p) -> vec { return _mm512_loadu_pd(p); }
+        FSRS_LANES("avx512f") static auto store(double* p, vec v) -> void { _mm512_storeu_pd(p, v); }
+        FSRS_LANES("avx512f") static auto set(double v) -> vec { return _mm512_set1_pd(v); }
+        FSRS_LANES("avx512f") static auto add(vec a, vec b) -> vec { return _mm512_add_pd(a, b); }
+        FSRS_LANES("avx512f") static auto sub(vec a, vec b) -> vec { return _mm512_sub_pd(a, b); }
+        FSRS_LANES("avx512f") static auto mul(vec a, vec b) -> vec { return _mm512_mul_pd(a, b); }
+        FSRS_LANES("avx512f") static auto div(vec a, vec b) -> vec { return _mm512_div_pd(a, b); }
+        FSRS_LANES("avx512f") static auto min(vec a, vec b) -> vec { return _mm512_min_pd(b, a); }
+        FSRS_LANES("avx512f") static auto max(vec a, vec b) -> vec { return _mm512_max_pd(b, a); }
+        FSRS_LANES("avx512f") static auto trunc(vec a) -> vec { return _mm512_roundscale_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+        FSRS_LANES("avx512f") static auto less(vec a, vec b) -> __mmask8 { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+        FSRS_LANES("avx512f") static auto equal(vec a, vec b) -> __mmask8 { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+        FSRS_LANES("avx512f") static auto select(__mmask8 m, vec a, vec b) -> vec { return _mm512_mask_blend_pd(m, b, a); }
+        FSRS_LANES("avx512f") static auto to_bits(vec v) -> ivec { return _mm512_castpd_si512(v); }
+        FSRS_LANES("avx512f") static auto from_bits(ivec v) -> vec { return _mm512_castsi512_pd(v); }
+        FSRS_LANES("avx512f") static auto iset(std::int64_t v) -> ivec { return _mm512_set1_epi64(v); }
+        FSRS_LANES("avx512f") static auto iadd(ivec a, ivec b) -> ivec { return _mm512_add_epi64(a, b); }
+        FSRS_LANES("avx512f") static auto isub(ivec a, ivec b) -> ivec { return _mm512_sub_epi64(a, b); }
+        FSRS_LANES("avx512f") static auto iand(ivec a, ivec b) -> ivec { return _mm512_and_si512(a, b); }
+        FSRS_LANES("avx512f") static auto ior(ivec a, ivec b) -> ivec { return _mm512_or_si512(a, b); }
+        template<int N> FSRS_LANES("avx512f") static auto ishl(ivec a) -> ivec { return _mm512_slli_epi64(a, N); }
+        template<int N> FSRS_LANES("avx512f") static auto ishr(ivec a) -> ivec { return _mm512_srli_epi64(a, N); }
+    };
+
+    struct Avx2Lanes {
+        using vec = __m256d;
+        using ivec = __m256i;
+        static constexpr std::size_t width = 4;
+        static constexpr const char* name = "avx2";
+
+        FSRS_LANES("avx2") static auto load(const double* p) -> vec { return _mm256_loadu_pd(p); }
+        FSRS_LANES("avx2") static auto store(double* p, vec v) -> void { _mm256_storeu_pd(p, v); }
+        FSRS_LANES("avx2") static auto set(double v) -> vec { return _mm256_set1_pd(v); }
+        FSRS_LANES("avx2") static auto add(vec a, vec b) -> vec { return _mm256_add_pd(a, b); }
+        FSRS_LANES("avx2") static auto sub(vec a, vec b) -> vec { return _mm256_sub_pd(a, b); }
+        FSRS_LANES("avx2") static auto mul(vec a, vec b) -> vec { return _mm256_mul_pd(a, b); }
+        FSRS_LANES("avx2") static auto div(vec a, vec b) -> vec { return _mm256_div_pd(a, b); }
+        FSRS_LANES("avx2") static auto min(vec a, vec b) -> vec { return _mm256_min_pd(b, a); }
+        FSRS_LANES("avx2") static auto max(vec a, vec b) -> vec { return _mm256_max_pd(b, a); }
+        FSRS_LANES("avx2") static auto trunc(vec a) -> vec { return _mm256_round_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+        FSRS_LANES("avx2") static auto less(vec a, vec b) -> vec { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+        FSRS_LANES("avx2") static auto equal(vec a, vec b) -> vec { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+        FSRS_LANES("avx2") static auto select(vec m, vec a, vec b) -> vec { return _mm256_blendv_pd(b, a, m); }
+        FSRS_LANES("avx2") static auto to_bits(vec v) -> ivec { return _mm256_castpd_si256(v); }
+        FSRS_LANES("avx2") static auto from_bits(ivec v) -> vec { return _mm256_castsi256_pd(v); }
+        FSRS_LANES("avx2") static auto iset(std::int64_t v) -> ivec { return _mm256_set1_epi64x(v); }
+        FSRS_LANES("avx2") static auto iadd(ivec a, ivec b) -> ivec { return _mm256_add_epi64(a, b); }
+        FSRS_LANES("avx2") static auto isub(ivec a, ivec b) -> ivec { return _mm256_sub_epi64(a, b); }
+        FSRS_LANES("avx2") static auto iand(ivec a, ivec b) -> ivec { return _mm256_and_si256(a, b); }
+        FSRS_LANES("avx2") static auto ior(ivec a, ivec b) -> ivec { return _mm256_or_si256(a, b); }
+        template<int N> FSRS_LANES("avx2") static auto ishl(ivec a) -> ivec { return _mm256_slli_epi64(a, N); }
+        template<int N> FSRS_LANES("avx2") static auto ishr(ivec a) -> ivec { return _mm256_srli_epi64(a, N); }
+    };
+#elif defined(FSRS_SIMD_NEON)
+    struct NeonLanes {
+        using vec = float64x2_t;
+        using ivec = int64x2_t;
+        static constexpr std::size_t width = 2;
+        static constexpr const char* name = "neon";
+
+        static auto load(const double* p) -> vec { return vld1q_f64(p); }
+        static auto store(double* p, vec v) -> void { vst1q_f64(p, v); }
+        static auto set(double v) -> vec { return vdupq_n_f64(v); }
+        static auto add(vec a, vec b) -> vec { return vaddq_f64(a, b); }
+        static auto sub(vec a, vec b) -> vec { return vsubq_f64(a, b); }
+        static auto mul(vec a, vec b) -> vec { return vmulq_f64(a, b); }
+        static auto div(vec a, vec b) -> vec { return vdivq_f64(a, b); }
+        static auto min(vec a, vec b) -> vec { return vbslq_f64(vcltq_f64(b, a), b, a); }
+        static auto max(vec a, vec b) -> vec { return vbslq_f64(vcltq_f64(a, b), b, a); }
+        static auto trunc(vec a) -> vec { return vrndq_f64(a); }
+        static auto less(vec a, vec b) -> uint64x2_t { return vcltq_f64(a, b); }
+        static auto equal(vec a, vec b) -> uint64x2_t { return vceqq_f64(a, b); }
+        static auto select(uint64x2_t m, vec a, vec b) -> vec { return vbslq_f64(m, a, b); }
+        static auto to_bits(vec v) -> ivec { return vreinterpretq_s64_f64(v); }
+        static auto from_bits(ivec v) -> vec { return vreinterpretq_f64_s64(v); }
+        static auto iset(std::int64_t v) -> ivec { return vdupq_n_s64(v); }
+        static auto iadd(ivec a, ivec b) -> ivec { return vaddq_s64(a, b); }
+        static auto isub(ivec a, ivec b) -> ivec { return vsubq_s64(a, b); }
+        static auto iand(ivec a, ivec b) -> ivec { return vandq_s64(a, b); }
+        static auto ior(ivec a, ivec b) -> ivec { return vorrq_s64(a, b); }
+        template<int N> static auto ishl(ivec a) -> ivec { return vshlq_n_s64(a, N); }
+        template<int N> static auto ishr(ivec a) -> ivec { return vreinterpretq_s64_u64(vshrq_n_u64(vreinterpretq_u64_s64(a), N)); }
+    };
+#endif
+
+    template<typename L>
+    auto exp_lanes(typename L::vec x) -> typename L::vec {
+        constexpr auto shifter = 0x1.8p52;
+
+        auto shifted = L::add(L::mul(x, L::set(1.4426950408889634)), L::set(shifter));
+        auto n = L::sub(shifted, L::set(shifter));
+        auto r = L::sub(L::sub(x, L::mul(n, L::set(6.93147180369123816490e-01))), L::mul(n, L::set(1.90821492927058770002e-10)));
+
+        constexpr auto coefficients = std::array{
+            1.0 / 6227020800.0, 1.0 / 479001600.0, 1.0 / 39916800.0, 1.0 / 3628800.0, 1.0 / 362880.0, 1.0 / 40320.0, 1.0 / 5040.0,
+            1.0 / 720.0, 1.0 / 120.0, 1.0 / 24.0, 1.0 / 6.0, 0.5, 1.0, 1.0 };
+        auto p = L::set(coefficients[0]);
+        for (std::size_t k = 1; k < coefficients.size(); ++k) {
+            p = L::add(L::mul(p, r), L::set(coefficients[k]));
+        }
+
+        auto k = L::isub(L::to_bits(shifted), L::iset(std::bit_cast<std::int64_t>(shifter)));
+        return L::mul(p, L::from_bits(L::template ishl<52>(L::iadd(k, L::iset(1023)))));
+    }
+
+    template<typename L>
+    auto log_lanes(typename L::vec x) -> typename L::vec {
+        constexpr auto shifter = 0x1.0p52;
+
+        auto bits = L::to_bits(x);
+        auto m = L::from_bits(L::ior(L::iand(bits, L::iset(0x000FFFFFFFFFFFFF)), L::iset(0x3FF0000000000000)));
+        auto exponent = L::sub(L::from_bits(L::ior(L::template ishr<52>(bits), L::iset(std::bit_cast<std::int64_t>(shifter)))), L::set(shifter + 1023.0));
+        auto high = L::less(L::set(std::numbers::sqrt2), m);
+        m = L::select(high, L::mul(m, L::set(0.5)), m);
+        auto e = L::add(exponent, L::select(high, L::set(1.0), L::set(0.0)));
+
+        auto f = L::sub(m, L::set(1.0));
+        auto s = L::div(f, L::add(L::set(2.0), f));
+        auto z = L::mul(s, s);
+
+        constexpr auto coefficients = std::array{
+            1.0 / 23.0, 1.0 / 21.0, 1.0 / 19.0, 1.0 / 17.0, 1.0 / 15.0, 1.0 / 13.0, 1.0 / 11.0, 1.0 / 9.0, 1.0 / 7.0, 1.0 / 5.0, 1.0 / 3.0 };
+        auto p = L::set(coefficients[0]);
+        for (std::size_t k = 1; k < coefficients.size(); ++k) {
+            p = L::add(L::mul(p, z), L::set(coefficients[k]));
+        }
+
+        auto half_f2 = L::mul(L::set(0.5), L::mul(f, f));
+        auto tail = L::add(half_f2, L::mul(L::mul(L::set(2.0), z), p));
+        auto log_m = L::sub(f, L::sub(half_f2, L::mul(s, tail)));
+        return L::add(L::mul(e, L::set(6.93147180369123816490e-01)), L::add(log_m, L::mul(e, L::set(1.90821492927058770002e-10))));
+    }
+
+    template<typename L>
+    auto pow_lanes(typename L::vec x, typename L::vec y) -> typename L::vec {
+        return exp_lanes<L>(L::mul(y, log_lanes<L>(x)));
+    }
+
+    template<typename L>
+    auto memory_state_block(const Coefficients& c, MemoryStateLanes lanes, std::size_t i) -> void {
+        constexpr auto min_difficulty = 1.0;
+        constexpr auto max_difficulty = 10.0;
+        constexpr auto stability_min = 0.001;
+
+        auto s = L::load(lanes.stability + i);
+        auto d = L::load(lanes.difficulty + i);
+        auto r = L::load(lanes.rating + i);
+        auto t = L::load(lanes.elapsed + i);
+        auto is_new = L::equal(L::load(lanes.is_new + i), L::set(1.0));
+        auto is_again = L::equal(r, L::set(1.0));
+        auto is_hard = L::equal(r, L::set(2.0));
+        auto is_good = L::equal(r, L::set(3.0));
+        auto by_rating = [&](const std::array<double, 4>& v) {
+            return L::select(is_again, L::set(v[0]), L::select(is_hard, L::set(v[1]), L::select(is_good, L::set(v[2]), L::set(v[3]))));
+        };
+
+        auto delta = L::mul(L::set(-c.w6), L::sub(r, L::set(3.0)));
+        auto damped = L::div(L::mul(L::sub(L::set(max_difficulty), d), delta), L::set(max_difficulty - min_difficulty));
+        auto mean_reverted = L::add(L::mul(L::set(c.w7), L::set(c.easy_difficulty)), L::mul(L::set(1.0 - c.w7), L::add(d, damped)));
+        auto next_d = L::min(L::max(mean_reverted, L::set(min_difficulty)), L::set(max_difficulty));
+
+        auto log_s = log_lanes<L>(s);
+        auto increase = L::mul(by_rating(c.short_term_increase), exp_lanes<L>(L::mul(L::set(-c.w19), log_s)));
+        increase = L::select(L::less(L::set(2.5), r), L::max(increase, L::set(1.0)), increase);
+        auto short_term = L::mul(s, increase);
+
+        auto elapsed = L::max(L::set(0.0), t);
+        auto retrievability = pow_lanes<L>(L::add(L::set(1.0), L::div(L::mul(L::set(c.factor), elapsed), s)), L::set(c.decay));
+        auto forgotten = L::sub(L::set(1.0), retrievability);
+        auto forget = L::mul(L::mul(L::mul(L::set(c.w11), exp_lanes<L>(L::mul(L::set(-c.w12), log_lanes<L>(d)))),
+            L::sub(exp_lanes<L>(L::mul(L::set(c.w13), log_lanes<L>(L::add(s, L::set(1.0))))), L::set(1.0))),
+            exp_lanes<L>(L::mul(forgotten, L::set(c.w14))));
+        auto stability_increase = L::mul(L::mul(L::mul(L::mul(L::set(c.recall_factor), L::sub(L::set(11.0), d)), exp_lanes<L>(L::mul(L::set(-c.w9), log_s))),
+            L::sub(exp_lanes<L>(L::mul(forgotten, L::set(c.w10))), L::set(1.0))), by_rating(c.recall_bonus));
+        auto recall = L::mul(s, L::add(L::set(1.0), stability_increase));
+        auto long_term = L::select(is_again, forget, recall);
+
+        auto next_s = L::max(L::select(L::less(t, L::set(1.0)), short_term, long_term), L::set(stability_min));
+        L::store(lanes.stability + i, L::select(is_new, by_rating(c.initial_stability), next_s));
+        L::store(lanes.difficulty + i, L::select(is_new, by_rating(c.initial_difficulty), next_d));
+    }
+
+    template<typename L>
+    auto retrievability_block(double factor, double decay, const double* stability, const double* elapsed, double* retrievability, std::size_t i) -> void {
+        auto s = L::load(stability + i);
+        auto t = L::max(L::set(0.0), L::load(elapsed + i));
+        auto r = pow_lanes<L>(L::add(L::set(1.0), L::div(L::mul(L::set(factor), t), s)), L::set(decay));
+        L::store(retrievability + i, L::select(L::less(L::set(0.0), s), r, L::set(0.0)));
+    }
+
+    // Matches std::round (half away from zero) for the positive intervals it sees: x - trunc(x) is exact.
+    template<typename L>
+    auto interval_block(double multiplier, double max_interval, const double* stability, double* intervals, std::size_t i) -> void {
+        auto days = L::mul(L::load(stability + i), L::set(multiplier));
+        auto whole = L::trunc(days);
+        auto rounded = L::add(whole, L::select(L::less(L::sub(days, whole), L::set(0.5)), L::set(0.0), L::set(1.0)));
+        L::store(intervals + i, L::min(L::max(rounded, L::set(1.0)), L::set(max_interval)));
+    }
+
+    template<typename L>
+    auto memory_states_with(const Coefficients& c, MemoryStateLanes lanes, std::size_t count) -> void {
+        auto i = std::size_t{};
+        for (; i + L::width <= count; i += L::width) {
+            memory_state_block<L>(c, lanes, i);
+        }
+        for (; i < count; ++i) {
+            memory_state_block<ScalarLanes>(c, lanes, i);
+        }
+    }
+
+    template<typename L>
+    auto retrievability_with(double factor, double decay, const double* stability, const double* elapsed, double* retrievability, std::size_t count) -> void {
+        auto i = std::size_t{};
+        for (; i + L::width <= count; i += L::width) {
+            retrievability_block<L>(factor, decay, stability, elapsed, retrievability, i);
+        }
+        for (; i < count; ++i) {
+            retrievability_block<ScalarLanes>(factor, decay, stability, elapsed, retrievability, i);
+        }
+    }
+
+    template<typename L>
+    auto intervals_with(double multiplier, double max_interval, const double* stability, double* intervals, std::size_t count) -> void {
+        auto i = std::size_t{};
+        for (; i + L::width <= count; i += L::width) {
+            interval_block<L>(multiplier, max_interval, stability, intervals, i);
+        }
+        for (; i < count; ++i) {
+            interval_block<ScalarLanes>(multiplier, max_interval, stability, intervals, i);
+        }
+    }
+
+    template<typename L>
+    constexpr auto make_backend(
+        void (*memory_states)(const Coefficients&, MemoryStateLanes, std::size_t),
+        void (*retrievability)(double, double, const double*, const double*, double*, std::size_t),
+        void (*intervals)(double, double, const double*, double*, std::size_t)) -> Backend {
+        return { L::name, L::width, memory_states, retrievability, intervals };
+    }
+
+    auto scalar_backend() -> Backend {
+        return make_backend<ScalarLanes>(memory_states_with<ScalarLanes>, retrievability_with<ScalarLanes>, intervals_with<ScalarLanes>);
+    }
+
+#if defined(FSRS_SIMD_X86)
+    FSRS_KERNEL("avx2") auto memory_states_avx2(const Coefficients& c, MemoryStateLanes lanes, std::size_t count) -> void {
+        memory_states_with<Avx2Lanes>(c, lanes, count);
+    }
+
+    FSRS_KERNEL("avx2") auto retrievability_avx2(double factor, double decay, const double* stability, const double* elapsed, double* retrievability, std::size_t count) -> void {
+        retrievability_with<Avx2Lanes>(factor, decay, stability, elapsed, retrievability, count);
+    }
+
+    FSRS_KERNEL("avx2") auto intervals_avx2(double multiplier, double max_interval, const double* stability, double* intervals, std::size_t count) -> void {
+        intervals_with<Avx2Lanes>(multiplier, max_interval, stability, intervals, count);
+    }
+
+    FSRS_KERNEL("avx512f") auto memory_states_avx512(const Coefficients& c, MemoryStateLanes lanes, std::size_t count) -> void {
+        memory_states_with<Avx512Lanes>(c, lanes, count);
+    }
+
+    FSRS_KERNEL("avx512f") auto retrievability_avx512(double factor, double decay, const double* stability, const double* elapsed, double* retrievability, std::size_t count) -> void {
+        retrievability_with<Avx512Lanes>(factor, decay, stability, elapsed, retrievability, count);
+    }
+
+    FSRS_KERNEL("avx512f") auto intervals_avx512(double multiplier, double max_interval, const double* stability, double* intervals, std::size_t count) -> void {
+        intervals_with<Avx512Lanes>(multiplier, max_interval, stability, intervals, count);
+    }
+
+    struct CpuFeatures {
+        bool avx2;
+        bool avx512;
+    };
+
+    auto detect_cpu_features() -> CpuFeatures {
+#if defined(_MSC_VER) && !defined(__clang__)
+        auto registers = std::array<int, 4>{};
+        __cpuid(registers.data(), 0);
+        if (registers[0] < 7) {
+            return {};
+        }
+        __cpuid(registers.data(), 1);
+        auto os_saves_ymm = (registers[2] & (1 << 27)) != 0 && (registers[2] & (1 << 28)) != 0;
+        if (!os_saves_ymm) {
+            return {};
+        }
+        auto xcr0 = _xgetbv(0);
+        __cpuidex(registers.data(), 7, 0);
+        auto avx2 = (xcr0 & 0x6) == 0x6 && (registers[1] & (1 << 5)) != 0;
+        auto avx512 = (xcr0 & 0xE6) == 0xE6 && (registers[1] & (1 << 16)) != 0;
+        return { avx2, avx2 && avx512 };
+#else
+        __builtin_cpu_init();
+        auto avx2 = __builtin_cpu_supports("avx2") != 0;
+        return { avx2, avx2 && __builtin_cpu_supports("avx512f") != 0 };
+#endif
+    }
+#endif
+
+    auto detect_backends() -> std::vector<Backend> {
+        auto backends = std::vector<Backend>{ scalar_backend() };
+#if defined(FSRS_SIMD_X86)
+        auto features = detect_cpu_features();
+        if (features.avx2) {
+            backends.push_back(make_backend<Avx2Lanes>(memory_states_avx2, retrievability_avx2, intervals_avx2));
+        }
+        if (features.avx512) {
+            backends.push_back(make_backend<Avx512Lanes>(memory_states_avx512, retrievability_avx512, intervals_avx512));
+        }
+#elif defined(FSRS_SIMD_NEON)
+        backends.push_back(make_backend<NeonLanes>(memory_states_with<NeonLanes>, retrievability_with<NeonLanes>, intervals_with<NeonLanes>));
+#endif
+        return backends;
+    }
+
+    auto supported_backends() -> std::span<const Backend> {
+        static const auto backends = detect_backends();
+        return backends;
+    }
+
+    auto backend() -> const Backend& {
+        static const auto& selected = supported_backends().back();
+        return selected;
+    }
+
+    auto memory_states(const Coefficients& c, MemoryStateLanes lanes, std::size_t count) -> void {
+        backend().memory_states(c, lanes, count);
+    }
+
+    auto fast_exp(double x) -> double {
+        return exp_lanes<ScalarLanes>(x);
+    }
+
+    auto fast_log(double x) -> double {
+        return log_lanes<ScalarLanes>(x);
+    }
+
+    auto fast_pow(double x, double y) -> double {
+        return pow_lanes<ScalarLanes>(x, y);
+    }
+
+    auto backend_name() -> const char* {
+        return backend().name;
+    }
+}
@@ -0,0 +1,263 @@
+module;
+
+#include <vector>
+#include <chrono>
+#include <random>
+#include <span>
+#include <numeric>
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <execution>
+#include <cmath>
+#include <limits>
+#include <memory_resource>
+
+export module FsrsCpp.Simulator;
+
+import FsrsCpp;
+
+export namespace FsrsCpp {
+
+    struct SimulatorConfig {
+        int days;
+        int runs;
+        int new_cards_per_day;
+        std::array<double, 4> first_rating_weights;
+        std::array<double, 3> recall_rating_weights;
+        std::array<double, 4> review_seconds;
+        std::uint64_t seed;
+        static const SimulatorConfig& get_default();
+    };
+
+    struct Forecast {
+        std::vector<double> reviews;
+        std::vector<double> lapses;
+        std::vector<double> seconds;
+        double retained;
+    };
+
+    struct RetentionSearchConfig {
+        double min_retention;
+        double max_retention;
+        double step;
+        static const RetentionSearchConfig& get_default();
+    };
+
+    struct RetentionCandidate {
+        double desired_retention;
+        double reviews;
+        double seconds;
+        double retained;
+        double cost;
+    };
+
+    struct RetentionSearchResult {
+        double desired_retention;
+        std::vector<RetentionCandidate> candidates;
+    };
+
+    class Simulator {
+    public:
+        Simulator(Scheduler scheduler, const SimulatorConfig& cfg);
+        auto forecast(std::span<const Card> cards, std::span<const days_t> elapsed, std::pmr::memory_resource* scratch = std::pmr::get_default_resource()) const -> Forecast;
+
+    private:
+        struct Histogram {
+            std::pmr::vector<std::uint64_t> reviews;
+            std::pmr::vector<std::uint64_t> lapses;
+            std::pmr::vector<double> seconds;
+            double retained = 0.0;
+        };
+
+        struct Sampler {
+            std::mt19937_64 rand_gen;
+            std::discrete_distribution<int> first_rating;
+            std::discrete_distribution<int> recall_rating;
+            std::uniform_real_distribution<double> uniform;
+        };
+
+        auto simulate_card(Card card, double last_review, double first_due, std::uint64_t review_index, Sampler& sampler, Histogram& histogram) const -> void;
+
+        Scheduler scheduler;
+        SimulatorConfig config;
+    };
+
+    auto optimize_retention(const SchedulerConfig& scheduler_config, const SimulatorConfig& simulator_config, const RetentionSearchConfig& search,
+        std::span<const Card> cards, std::span<const days_t> elapsed, std::uint64_t rand_seed = 0) -> RetentionSearchResult;
+}
+
+namespace FsrsSimulation {
+    constexpr std::size_t CHUNK_SIZE = 4096;
+
+    // seed_seq keeps only the low 32 bits of each element, so every 64-bit value is passed as two words.
+    auto stream_seed(std::uint64_t seed, std::uint64_t run, std::uint64_t chunk) -> std::seed_seq {
+        auto words = std::array<std::uint32_t, 6>{};
+        auto i = std::size_t{};
+        for (auto value : { seed, run, chunk }) {
+            words[i++] = static_cast<std::uint32_t>(value);
+            words[i++] = static_cast<std::uint32_t>(value >> 32);
+        }
+        return std::seed_seq(words.begin(), words.end());
+    }
+
+    auto valid_weights(std::span<const double> weights) -> bool {
+        return std::ranges::all_of(weights, [](double w) { return w >= 0.0; }) && std::accumulate(weights.begin(), weights.end(), 0.0) > 0.0;
+    }
+}
+
+namespace FsrsCpp {
+
+    const SimulatorConfig& SimulatorConfig::get_default() {
+        static const SimulatorConfig Default = {
+            .days = 365,
+            .runs = 1,
+            .new_cards_per_day = 0,
+            .first_rating_weights = { 0.2, 0.1, 0.6, 0.1 },
+            .recall_rating_weights = { 0.15, 0.75, 0.1 },
+            .review_seconds = { 23.0, 12.0, 8.0, 6.0 },
+            .seed = 0
+        };
+        return Default;
+    }
+
+    Simulator::Simulator(Scheduler scheduler, const SimulatorConfig& cfg)
+        : scheduler(std::move(scheduler)),
+        config(cfg) {
+        if (config.days <= 0 || config.runs <= 0 || config.new_cards_per_day < 0) {
+            throw std::invalid_argument("Invalid simulator config: days and runs must be positive and new cards non-negative.");
+        }
+        if (!FsrsSimulation::valid_weights(config.first_rating_weights) || !FsrsSimulation::valid_weights(config.recall_rating_weights)) {
+            throw std::invalid_argument("Invalid simulator config: rating weights must be non-negative with a positive sum.");
+        }
+        if (std::ranges::any_of(config.review_seconds, [](double s) { return !(s >= 0.0); })) {
+            throw std::invalid_argument("Invalid simulator config: review seconds must be non-negative.");
+        }
+    }
+
+    auto Simulator::forecast(std::span<const Card> cards, std::span<const days_t> elapsed, std::pmr::memory_resource* scratch) const -> Forecast {
+        if (cards.size() != elapsed.size()) {
+            throw std::invalid_argument("Invalid batch: all columns must have the same length.");
+        }
+
+        auto days = static_cast<std::size_t>(config.days);
+        auto new_cards = days * static_cast<std::size_t>(config.new_cards_per_day);
+        auto total = cards.size() + new_cards;
+        auto chunks = (total + FsrsSimulation::CHUNK_SIZE - 1) / FsrsSimulation::CHUNK_SIZE;
+        auto task_count = chunks * static_cast<std::size_t>(config.runs);
+        auto histograms = std::pmr::vector<Histogram>(scratch);
+        histograms.reserve(task_count);
+        for (std::size_t i = 0; i < task_count; ++i) {
+            histograms.push_back({ std::pmr::vector<std::uint64_t>(days, scratch), std::pmr::vector<std::uint64_t>(days, scratch), std::pmr::vector<double>(days, scratch) });
+        }
+        auto tasks = std::pmr::vector<std::size_t>(histograms.size(), scratch);
+        std::iota(tasks.begin(), tasks.end(), std::size_t{});
+
+        std::for_each(std::execution::par, tasks.begin(), tasks.end(), [&](std::size_t task) {
+            auto run = static_cast<int>(task / chunks);
+            auto chunk = task % chunks;
+            auto seeds = FsrsSimulation::stream_seed(config.seed, static_cast<std::uint64_t>(run), chunk);
+            auto sampler = Sampler{
+                std::mt19937_64(seeds),
+                std::discrete_distribution<int>(config.first_rating_weights.begin(), config.first_rating_weights.end()),
+                std::discrete_distribution<int>(config.recall_rating_weights.begin(), config.recall_rating_weights.end()),
+                std::uniform_real_distribution<double>(0.0, 1.0)
+            };
+            auto review_index = static_cast<std::uint64_t>(run) << 32;
+            auto& histogram = histograms[task];
+
+            auto end = std::min(total, (chunk + 1) * FsrsSimulation::CHUNK_SIZE);
+            for (auto i = chunk * FsrsSimulation::CHUNK_SIZE; i < end; ++i) {
+                if (i < cards.size()) {
+                    auto due = (cards[i].state == State::New) ? 0.0 : std::max(0.0, (cards[i].interval - elapsed[i]).count());
+                    simulate_card(cards[i], -elapsed[i].count(), due, review_index, sampler, histogram);
+                }
+                else {
+                    auto k = i - cards.size();
+                    auto intro_day = static_cast<double>(k / static_cast<std::size_t>(config.new_cards_per_day));
+                    simulate_card(Card::create(-1 - static_cast<long long>(k)), intro_day, intro_day, review_index, sampler, histogram);
+                }
+            }
+        });
+
+        auto forecast = Forecast{ std::vector<double>(days), std::vector<double>(days), std::vector<double>(days), 0.0 };
+        for (const auto& histogram : histograms) {
+            forecast.retained += histogram.retained;
+            for (std::size_t day = 0; day < days; ++day) {
+                forecast.reviews[day] += static_cast<double>(histogram.reviews[day]);
+                forecast.lapses[day] += static_cast<double>(histogram.lapses[day]);
+                forecast.seconds[day] += histogram.seconds[day];
+            }
+        }
+        for (std::size_t day = 0; day < days; ++day) {
+            forecast.reviews[day] /= config.runs;
+            forecast.lapses[day] /= config.runs;
+            forecast.seconds[day] /= config.runs;
+        }
+        forecast.retained /= config.runs;
+        return forecast;
+    }
+
+    auto Simulator::simulate_card(Card card, double last_review, double first_due, std::uint64_t review_index, Sampler& sampler, Histogram& histogram) const -> void {
+        auto horizon = static_cast<double>(config.days);
+
+        for (auto t = first_due; t < horizon; t += card.interval.count()) {
+            auto day = static_cast<std::size_t>(t);
+            auto since = days_t(t - last_review);
+            auto rating = Rating::Again;
+            if (card.state == State::New) {
+                rating = static_cast<Rating>(sampler.first_rating(sampler.rand_gen) + 1);
+            }
+            else if (sampler.uniform(sampler.rand_gen) < scheduler.get_retrievability(card, since)) {
+                rating = static_cast<Rating>(sampler.recall_rating(sampler.rand_gen) + 2);
+            }
+
+            histogram.reviews[day]++;
+            histogram.seconds[day] += config.review_seconds[static_cast<int>(rating) - 1];
+            if (rating == Rating::Again && card.state == State::Review) {
+                histogram.lapses[day]++;
+            }
+            card = scheduler.review_card(card, rating, since, review_index++);
+            last_review = t;
+        }
+
+        if (first_due < horizon) {
+            histogram.retained += scheduler.get_retrievability(card, days_t(horizon - last_review));
+        }
+    }
+
+    const RetentionSearchConfig& RetentionSearchConfig::get_default() {
+        static const RetentionSearchConfig Default = {
+            .min_retention = 0.70,
+            .max_retention = 0.97,
+            .step = 0.01
+        };
+        return Default;
+    }
+
+    auto optimize_retention(const SchedulerConfig& scheduler_config, const SimulatorConfig& simulator_config, const RetentionSearchConfig& search,
+        std::span<const Card> cards, std::span<const days_t> elapsed, std::uint64_t rand_seed) -> RetentionSearchResult {
+        if (!(search.min_retention > 0.0 && search.min_retention <= search.max_retention && search.max_retention < 1.0 && search.step > 0.0)) {
+            throw std::invalid_argument("Invalid retention search: require 0 < min_retention <= max_retention < 1 and a positive step.");
+        }
+
+        auto count = static_cast<std::size_t>(std::floor((search.max_retention - search.min_retention) / search.step + 1e-9)) + 1;
+        auto result = RetentionSearchResult{ 0.0, std::vector<RetentionCandidate>(count) };
+        auto indices = std::vector<std::size_t>(count);
+        std::iota(indices.begin(), indices.end(), std::size_t{});
+        std::for_each(std::execution::par, indices.begin(), indices.end(), [&](std::size_t i) {
+            auto config = scheduler_config;
+            config.desired_retention = search.min_retention + static_cast<double>(i) * search.step;
+            auto forecast = Simulator(Scheduler(config, rand_seed), simulator_config).forecast(cards, elapsed);
+            auto reviews = std::accumulate(forecast.reviews.begin(), forecast.reviews.end(), 0.0);
+            auto seconds = std::accumulate(forecast.seconds.begin(), forecast.seconds.end(), 0.0);
+            auto cost = (forecast.retained > 0.0) ? seconds / forecast.retained : std::numeric_limits<double>::infinity();
+            result.candidates[i] = { config.desired_retention, reviews, seconds, forecast.retained, cost };
+        });
+
+        auto best = std::ranges::min_element(result.candidates, {}, &RetentionCandidate::cost);
+        result.desired_retention = best->desired_retention;
+        return result;
+    }
+}
@@ -0,0 +1,331 @@
+module;
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+export module FsrsCpp.Store;
+
+import FsrsCpp;
+
+export namespace FsrsCpp {
+
+    class CardStore {
+    public:
+        enum class Access { ReadOnly, ReadWrite, CopyOnWrite };
+
+        static auto write(const std::filesystem::path& path, std::span<const Card> cards) -> void;
+        static auto write(const std::filesystem::path& path, CardColumns cards) -> void;
+        static auto open(const std::filesystem::path& path, Access access = Access::ReadOnly) -> CardStore;
+
+        CardStore(CardStore&& other) noexcept;
+        auto operator=(CardStore&& other) noexcept -> CardStore&;
+        CardStore(const CardStore&) = delete;
+        auto operator=(const CardStore&) -> CardStore& = delete;
+        ~CardStore();
+
+        auto size() const -> std::size_t;
+        auto card(std::size_t index) const -> Card;
+        // Opening only checks the header and layout, so the columns are never touched; verify() scans the state column.
+        auto verify() const -> void;
+        auto card_id() const -> std::span<const long long>;
+        auto interval() const -> std::span<const days_t>;
+        auto stability() const -> std::span<const double>;
+        auto difficulty() const -> std::span<const double>;
+        auto state() const -> std::span<const State>;
+        auto step() const -> std::span<const int>;
+        auto columns() -> CardColumns;
+        auto flush() -> void;
+
+    private:
+        CardStore() = default;
+        template<typename T>
+        auto column(std::size_t index) const -> T*;
+
+        std::byte* base = nullptr;
+        std::size_t length = 0;
+        std::size_t count = 0;
+        std::array<std::size_t, 6> offsets{};
+        Access access = Access::ReadOnly;
+    };
+}
+
+namespace FsrsStorage {
+    using namespace FsrsCpp;
+
+    static_assert(std::endian::native == std::endian::little, "The card store format is little-endian.");
+    static_assert(sizeof(days_t) == 8 && sizeof(State) == 4 && sizeof(int) == 4 && sizeof(long long) == 8);
+
+    constexpr std::array<char, 8> MAGIC = { 'F', 'S', 'R', 'S', 'C', 'A', 'R', 'D' };
+    constexpr std::uint32_t VERSION = 1;
+    constexpr std::size_t COLUMN_ALIGNMENT = 64;
+    constexpr std::array<std::size_t, 6> COLUMN_WIDTHS = { 8, 8, 8, 8, 4, 4 };
+    constexpr std::size_t CARD_WIDTH = std::accumulate(COLUMN_WIDTHS.begin(), COLUMN_WIDTHS.end(), std::size_t{});
+
+    struct Header {
+        std::array<char, 8> magic;
+        std::uint32_t version;
+        std::uint32_t header_size;
+        std::uint64_t count;
+        std::array<std::uint64_t, 6> column_offset;
+    };
+
+    auto align(std::size_t offset) -> std::size_t {
+        return (offset + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+    }
+
+    auto make_header(std::size_t count) -> Header {
+        auto header = Header{ MAGIC, VERSION, sizeof(Header), count, {} };
+        auto offset = align(sizeof(Header));
+        for (std::size_t i = 0; i < COLUMN_WIDTHS.size(); ++i) {
+            header.column_offset[i] = offset;
+            offset = align(offset + COLUMN_WIDTHS[i] * count);
+        }
+        return header;
+    }
+
+    auto file_size(const Header& header) -> std::size_t {
+        return align(header.column_offset.back() + COLUMN_WIDTHS.back() * header.count);
+    }
+
+    auto write_columns(const std::filesystem::path& path, std::size_t count, const std::array<const void*, 6>& columns) -> void {
+        auto header = make_header(count);
+        auto bytes = std::vector<char>(file_size(header));
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        for (std::size_t i = 0; i < columns.size(); ++i) {
+            if (count != 0) {
+                std::memcpy(bytes.data() + header.column_offset[i], columns[i], COLUMN_WIDTHS[i] * count);
+            }
+        }
+
+        auto file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!file) {
+            throw std::runtime_error("Card store: failed to write " + path.string());
+        }
+    }
+
+    auto map_file(const std::filesystem::path& path, CardStore::Access access) -> std::pair<std::byte*, std::size_t> {
+#if defined(_WIN32)
+        auto writable = access == CardStore::Access::ReadWrite;
+        auto file = CreateFileW(path.c_str(), GENERIC_READ | (writable ? GENERIC_WRITE : 0), FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Card store: cannot open " + path.string());
+        }
+        auto size = LARGE_INTEGER{};
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            CloseHandle(file);
+            throw std::invalid_argument("Invalid card store: file is empty.");
+        }
+        auto protection = writable ? PAGE_READWRITE : (access == CardStore::Access::CopyOnWrite) ? PAGE_WRITECOPY : PAGE_READONLY;
+        auto mapping = CreateFileMappingW(file, nullptr, protection, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr) {
+            throw std::runtime_error("Card store: cannot map " + path.string());
+        }
+        auto view_access = writable ? FILE_MAP_WRITE : (access == CardStore::Access::CopyOnWrite) ? FILE_MAP_COPY : FILE_MAP_READ;
+        auto view = MapViewOfFile(mapping, view_access, 0, 0, 0);
+        CloseHandle(mapping);
+        if (view == nullptr) {
+            throw std::runtime_error("Card store: cannot map " + path.string());
+        }
+        return { static_cast<std::byte*>(view), static_cast<std::size_t>(size.QuadPart) };
+#else
+        auto fd = ::open(path.c_str(), access == CardStore::Access::ReadWrite ? O_RDWR : O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Card store: cannot open " + path.string());
+        }
+        struct stat info {};
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            throw std::invalid_argument("Invalid card store: file is empty.");
+        }
+        auto protection = (access == CardStore::Access::ReadOnly) ? PROT_READ : PROT_READ | PROT_WRITE;
+        auto flags = (access == CardStore::Access::CopyOnWrite) ? MAP_PRIVATE : MAP_SHARED;
+        auto view = mmap(nullptr, static_cast<std::size_t>(info.st_size), protection, flags, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED) {
+            throw std::runtime_error("Card store: cannot map " + path.string());
+        }
+        return { static_cast<std::byte*>(view), static_cast<std::size_t>(info.st_size) };
+#endif
+    }
+
+    auto unmap_file(std::byte* base, std::size_t length) -> void {
+#if defined(_WIN32)
+        (void)length;
+        UnmapViewOfFile(base);
+#else
+        munmap(base, length);
+#endif
+    }
+
+    auto validate(const std::byte* base, std::size_t length) -> Header {
+        auto header = Header{};
+        if (length < sizeof(Header)) {
+            throw std::invalid_argument("Invalid card store: file is truncated.");
+        }
+        std::memcpy(&header, base, sizeof(header));
+        if (header.magic != MAGIC) {
+            throw std::invalid_argument("Invalid card store: bad magic.");
+        }
+        if (header.version != VERSION || header.header_size != sizeof(Header)) {
+            throw std::invalid_argument("Invalid card store: unsupported version.");
+        }
+        if (header.count > (length - sizeof(Header)) / CARD_WIDTH) {
+            throw std::invalid_argument("Invalid card store: card count does not fit in the file.");
+        }
+        auto expected = make_header(static_cast<std::size_t>(header.count));
+        if (header.column_offset != expected.column_offset || length < file_size(expected)) {
+            throw std::invalid_argument("Invalid card store: column layout does not match the card count.");
+        }
+        return header;
+    }
+
+    auto known_state(State state) -> bool {
+        return state >= State::New && state <= State::Relearning;
+    }
+}
+
+namespace FsrsCpp {
+
+    auto CardStore::write(const std::filesystem::path& path, std::span<const Card> cards) -> void {
+        auto id = std::vector<long long>();
+        auto interval = std::vector<days_t>();
+        auto stability = std::vector<double>();
+        auto difficulty = std::vector<double>();
+        auto state = std::vector<State>();
+        auto step = std::vector<int>();
+        for (const auto& card : cards) {
+            id.push_back(card.card_id);
+            interval.push_back(card.interval);
+            stability.push_back(card.stability);
+            difficulty.push_back(card.difficulty);
+            state.push_back(card.state);
+            step.push_back(card.step);
+        }
+        write(path, CardColumns{ id, interval, stability, difficulty, state, step });
+    }
+
+    auto CardStore::write(const std::filesystem::path& path, CardColumns cards) -> void {
+        auto n = cards.size();
+        if (cards.interval.size() != n || cards.stability.size() != n || cards.difficulty.size() != n || cards.state.size() != n || cards.step.size() != n) {
+            throw std::invalid_argument("Invalid batch: all columns must have the same length.");
+        }
+        FsrsStorage::write_columns(path, n, { cards.card_id.data(), cards.interval.data(), cards.stability.data(), cards.difficulty.data(), cards.state.data(), cards.step.data() });
+    }
+
+    auto CardStore::open(const std::filesystem::path& path, Access access) -> CardStore {
+        auto [base, length] = FsrsStorage::map_file(path, access);
+        auto store = CardStore();
+        store.base = base;
+        store.length = length;
+        store.access = access;
+        auto header = FsrsStorage::validate(base, length);
+        store.count = static_cast<std::size_t>(header.count);
+        std::ranges::copy(header.column_offset, store.offsets.begin());
+        return store;
+    }
+
+    CardStore::CardStore(CardStore&& other) noexcept
+        : base(std::exchange(other.base, nullptr)),
+        length(std::exchange(other.length, 0)),
+        count(std::exchange(other.count, 0)),
+        offsets(other.offsets),
+        access(other.access) {
+    }
+
+    auto CardStore::operator=(CardStore&& other) noexcept -> CardStore& {
+        if (this != &other) {
+            if (base != nullptr) {
+                FsrsStorage::unmap_file(base, length);
+            }
+            base = std::exchange(other.base, nullptr);
+            length = std::exchange(other.length, 0);
+            count = std::exchange(other.count, 0);
+            offsets = other.offsets;
+            access = other.access;
+        }
+        return *this;
+    }
+
+    CardStore::~CardStore() {
+        if (base != nullptr) {
+            FsrsStorage::unmap_file(base, length);
+        }
+    }
+
+    template<typename T>
+    auto CardStore::column(std::size_t index) const -> T* {
+        return reinterpret_cast<T*>(base + offsets[index]);
+    }
+
+    auto CardStore::size() const -> std::size_t {
+        return count;
+    }
+
+    auto CardStore::card(std::size_t index) const -> Card {
+        if (index >= count) {
+            throw std::out_of_range("Card store index out of range.");
+        }
+        if (!FsrsStorage::known_state(state()[index])) {
+            throw std::invalid_argument("Invalid card store: state column holds an unknown state.");
+        }
+        return { card_id()[index], interval()[index], stability()[index], difficulty()[index], state()[index], step()[index] };
+    }
+
+    auto CardStore::verify() const -> void {
+        if (!std::ranges::all_of(state(), FsrsStorage::known_state)) {
+            throw std::invalid_argument("Invalid card store: state column holds an unknown state.");
+        }
+    }
+
+    auto CardStore::card_id() const -> std::span<const long long> { return { column<const long long>(0), count }; }
+    auto CardStore::interval() const -> std::span<const days_t> { return { column<const days_t>(1), count }; }
+    auto CardStore::stability() const -> std::span<const double> { return { column<const double>(2), count }; }
+    auto CardStore::difficulty() const -> std::span<const double> { return { column<const double>(3), count }; }
+    auto CardStore::state() const -> std::span<const State> { return { column<const State>(4), count }; }
+    auto CardStore::step() const -> std::span<const int> { return { column<const int>(5), count }; }
+
+    auto CardStore::columns() -> CardColumns {
+        if (access == Access::ReadOnly) {
+            throw std::logic_error("Card store is mapped read-only: open it with ReadWrite or CopyOnWrite to get mutable columns.");
+        }
+        return { { column<long long>(0), count }, { column<days_t>(1), count }, { column<double>(2), count },
+            { column<double>(3), count }, { column<State>(4), count }, { column<int>(5), count } };
+    }
+
+    auto CardStore::flush() -> void {
+        if (access != Access::ReadWrite || base == nullptr) {
+            return;
+        }
+#if defined(_WIN32)
+        if (!FlushViewOfFile(base, length)) {
+#else
+        if (msync(base, length, MS_SYNC) != 0) {
+#endif
+            throw std::runtime_error("Card store: failed to flush mapped data.");
+        }
+    }
+}